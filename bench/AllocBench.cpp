@@ -0,0 +1,146 @@
+// Allocation microbenchmark: binary-trees built from LoxInstances.
+//
+// Every node is an instance of an empty class whose two children are
+// fields, so the run is dominated by creating instances, storing and
+// loading object references and reclaiming dead trees. One long-lived
+// tree stays reachable throughout while short-lived ones of growing
+// depth are built, checked and dropped. All three engines run the same
+// script and must print the same checksums.
+//
+//   alloc_bench [maxDepth]
+
+#include "../src/Lexer/Lexer.h"
+#include "../src/Parser/Parser.h"
+#include "../src/Semantic/Resolver.h"
+#include "../src/Interpreter/Interpreter.h"
+#include "../src/VM/Compiler.h"
+#include "../src/VM/VM.h"
+#include "../src/ClosureCompiler/ClosureCompiler.h"
+#include "../src/Runtime/CompilationUnit.h"
+#include "../src/Runtime/FlatAst.h"
+#include "../src/Runtime/Heap.h"
+#include "../src/Runtime/SourceBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+struct Run {
+    double seconds;
+    std::size_t nodes;
+    std::size_t collections;
+    std::string output;
+};
+
+enum class Engine { TREE, VM, CLOSURE };
+
+static Run run(Engine engine, const std::string& source) {
+    CompilationUnit unit(SourceBuffer::fromString(source));
+
+    Lexer lexer(unit.text());
+    Parser parser(lexer, unit);
+    unit.statements = parser.parse();
+    Resolver(unit.arena).resolve(unit.statements);
+
+    Heap::Stats before = Heap::stats();
+    std::ostringstream captured;
+    std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    switch (engine) {
+    case Engine::TREE: {
+        Interpreter interpreter;
+        interpreter.interpret(unit.statements);
+        break;
+    }
+    case Engine::VM: {
+        VM vm;
+        vm.interpret(Compiler::compile(FlatAst::build(unit.statements, unit.text())));
+        break;
+    }
+    case Engine::CLOSURE: {
+        ClosureEngine closureEngine;
+        closureEngine.interpret(unit.statements);
+        break;
+    }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(previous);
+
+    const Heap::Stats& after = Heap::stats();
+    return {std::chrono::duration<double>(end - start).count(),
+            after.objectsAllocated - before.objectsAllocated,
+            after.collections - before.collections,
+            captured.str()};
+}
+
+static Run bestOf(int runs, Engine engine, const std::string& source) {
+    Run best = run(engine, source);
+
+    for (int i = 1; i < runs; i++) {
+        Run next = run(engine, source);
+        if (next.seconds < best.seconds) best = next;
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int maxDepth = argc > 1 ? std::atoi(argv[1]) : 14;
+
+    // `while` loops are written as `for`, and the power of two is built
+    // by doubling, as Lox has neither bit shifts nor exponentiation
+    const std::string source =
+        "class Tree {}\n"
+        "fun bottomUp(depth) {\n"
+        "  var node = Tree();\n"
+        "  if (depth > 0) {\n"
+        "    node.left = bottomUp(depth - 1);\n"
+        "    node.right = bottomUp(depth - 1);\n"
+        "  } else {\n"
+        "    node.left = nil;\n"
+        "    node.right = nil;\n"
+        "  }\n"
+        "  return node;\n"
+        "}\n"
+        "fun check(node) {\n"
+        "  if (node.left == nil) return 1;\n"
+        "  return 1 + check(node.left) + check(node.right);\n"
+        "}\n"
+        "var minDepth = 4;\n"
+        "var maxDepth = " + std::to_string(maxDepth) + ";\n"
+        "print check(bottomUp(maxDepth + 1));\n"
+        "var longLived = bottomUp(maxDepth);\n"
+        "for (var depth = minDepth; depth <= maxDepth; depth = depth + 2) {\n"
+        "  var iterations = 1;\n"
+        "  for (var i = 0; i < maxDepth - depth + minDepth; i = i + 1) iterations = iterations * 2;\n"
+        "  var sum = 0;\n"
+        "  for (var i = 0; i < iterations; i = i + 1) sum = sum + check(bottomUp(depth));\n"
+        "  print sum;\n"
+        "}\n"
+        "print check(longLived);\n";
+
+    Run tree = bestOf(3, Engine::TREE, source);
+    Run vm = bestOf(3, Engine::VM, source);
+    Run closure = bestOf(3, Engine::CLOSURE, source);
+
+    if (tree.output != vm.output || tree.output != closure.output) {
+        std::printf("engines disagree:\n%s--\n%s--\n%s",
+                    tree.output.c_str(), vm.output.c_str(), closure.output.c_str());
+        return 1;
+    }
+
+    std::printf("binary-trees(%d): %zu objects\n", maxDepth, tree.nodes);
+    std::printf("tree      %8.1f ms  %6.1f ns/object  %4zu collections\n",
+                tree.seconds * 1e3, tree.seconds * 1e9 / tree.nodes, tree.collections);
+    std::printf("vm        %8.1f ms  %6.1f ns/object  %4zu collections\n",
+                vm.seconds * 1e3, vm.seconds * 1e9 / vm.nodes, vm.collections);
+    std::printf("closure   %8.1f ms  %6.1f ns/object  %4zu collections\n",
+                closure.seconds * 1e3, closure.seconds * 1e9 / closure.nodes, closure.collections);
+
+    return 0;
+}
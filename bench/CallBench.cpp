@@ -0,0 +1,112 @@
+// Call microbenchmark for the tree-walking interpreter.
+//
+// Runs the same recursive fib twice, once returning its result and
+// once falling off the end of every call and accumulating into a
+// global, so the two make exactly the same calls and the gap between
+// them is what `return` costs. A third program returns from inside a
+// loop nested in blocks. Both fib variants must print the same number.
+//
+//   call_bench [n]
+
+#include "../src/Lexer/Lexer.h"
+#include "../src/Parser/Parser.h"
+#include "../src/Semantic/Resolver.h"
+#include "../src/Interpreter/Interpreter.h"
+#include "../src/Runtime/CompilationUnit.h"
+#include "../src/Runtime/SourceBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+struct Run {
+    double seconds;
+    std::string output;
+};
+
+static Run runTree(const std::string& source) {
+    CompilationUnit unit(SourceBuffer::fromString(source));
+
+    Lexer lexer(unit.text());
+    Parser parser(lexer, unit);
+    unit.statements = parser.parse();
+    Resolver(unit.arena).resolve(unit.statements);
+
+    Interpreter interpreter;
+    std::ostringstream captured;
+    std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+
+    auto start = std::chrono::steady_clock::now();
+    interpreter.interpret(unit.statements);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout.rdbuf(previous);
+    return {std::chrono::duration<double>(end - start).count(), captured.str()};
+}
+
+static Run bestOf(int runs, const std::string& source) {
+    Run best = runTree(source);
+
+    for (int i = 1; i < runs; i++) {
+        Run run = runTree(source);
+        if (run.seconds < best.seconds) best = run;
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? std::atoi(argv[1]) : 25;
+    std::string arg = std::to_string(n);
+
+    const std::string returning =
+        "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }\n"
+        "print fib(" + arg + ");\n";
+
+    const std::string fallThrough =
+        "var result = 0;\n"
+        "fun fib(n) { if (n < 2) result = result + n; else { fib(n - 2); fib(n - 1); } }\n"
+        "fib(" + arg + ");\n"
+        "print result;\n";
+
+    // fib(n) makes 2 * fib(n + 1) - 1 calls
+    double a = 0, b = 1;
+    for (int i = 0; i <= n; i++) {
+        double next = a + b;
+        a = b;
+        b = next;
+    }
+    double calls = 2 * a - 1;
+
+    const std::string earlyReturn =
+        "fun find(limit) {\n"
+        "  for (var i = 0; i < limit; i = i + 1) { { if (i == 3) return i; } }\n"
+        "  return -1;\n"
+        "}\n"
+        "var total = 0;\n"
+        "for (var i = 0; i < " + std::to_string(static_cast<long>(calls)) + "; i = i + 1) {\n"
+        "  total = total + find(10);\n"
+        "}\n"
+        "print total;\n";
+
+    Run withReturn = bestOf(3, returning);
+    Run withoutReturn = bestOf(3, fallThrough);
+    Run early = bestOf(3, earlyReturn);
+
+    if (withReturn.output != withoutReturn.output) {
+        std::printf("fib variants disagree: %s vs %s\n",
+                    withReturn.output.c_str(), withoutReturn.output.c_str());
+        return 1;
+    }
+
+    std::printf("fib(%d): %.0f calls\n", n, calls);
+    std::printf("return         %7.1f ns/call\n", withReturn.seconds * 1e9 / calls);
+    std::printf("fall-through   %7.1f ns/call\n", withoutReturn.seconds * 1e9 / calls);
+    std::printf("early return   %7.1f ns/call\n", early.seconds * 1e9 / calls);
+    std::printf("return cost:   %.2fx\n", withReturn.seconds / withoutReturn.seconds);
+
+    return 0;
+}
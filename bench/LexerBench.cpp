@@ -0,0 +1,198 @@
+// Lexer microbenchmarks.
+//
+// Compares the keyword classification the lexer used to do (build a
+// std::string per identifier, look it up in an unordered_map) with
+// Keywords::classify, then reports end-to-end Lexer throughput for
+// every SimdScan level on an identifier-heavy script and on a script
+// made of comments and long string tables. Token streams from all
+// levels are checked against the scalar one.
+//
+//   lexer_bench [lines]
+
+#include "../src/Lexer/Lexer.h"
+#include "../src/Lexer/Keywords.h"
+#include "../src/Lexer/SimdScan.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+static const std::unordered_map<std::string, TokenType> mapKeywords = {
+    {"and",    TokenType::AND},
+    {"class",  TokenType::CLASS},
+    {"else",   TokenType::ELSE},
+    {"false",  TokenType::FALSE},
+    {"for",    TokenType::FOR},
+    {"fun",    TokenType::FUN},
+    {"if",     TokenType::IF},
+    {"nil",    TokenType::NIL},
+    {"or",     TokenType::OR},
+    {"print",  TokenType::PRINT},
+    {"return", TokenType::RETURN},
+    {"super",  TokenType::SUPER},
+    {"this",   TokenType::THIS},
+    {"true",   TokenType::TRUE},
+    {"var",    TokenType::VAR},
+    {"while",  TokenType::WHILE}
+};
+
+static std::string generateSource(int lines) {
+    static const char* names[] = {
+        "value", "index", "accumulatedTotal", "x", "tmp", "fore", "classy",
+        "thisOne", "returnValue", "superNode", "printer", "nilable", "i",
+        "whileCount", "an", "orange", "very_long_identifier_name_here"
+    };
+    const int count = sizeof(names) / sizeof(names[0]);
+
+    std::string source;
+    for (int i = 0; i < lines; i++) {
+        const char* a = names[i % count];
+        const char* b = names[(i * 7 + 3) % count];
+        const char* c = names[(i * 13 + 5) % count];
+
+        source += "var ";
+        source += a;
+        source += std::to_string(i);
+        source += " = ";
+        source += b;
+        source += " and ";
+        source += c;
+        source += " or this.";
+        source += a;
+        source += " == nil;\n";
+    }
+
+    return source;
+}
+
+static std::string generateCommentsAndStrings(int lines) {
+    std::string source;
+    for (int i = 0; i < lines; i++) {
+        if (i % 3 == 0) {
+            source += "    // Generated entry " + std::to_string(i) +
+                      ": this comment runs on for a while, as generated comments tend to do\n";
+        }
+        else {
+            source += "var s" + std::to_string(i) +
+                      " = \"Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+                      "sed do eiusmod tempor incididunt ut labore\";\n";
+        }
+
+        if (i % 50 == 0) {
+            source += "var table = \"multi-line\n  string\n  table\";\n\n\n";
+        }
+    }
+
+    return source;
+}
+
+static bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+    if (a.size() != b.size()) return false;
+
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a[i].type != b[i].type ||
+            a[i].line != b[i].line ||
+            a[i].lexeme.data() != b[i].lexeme.data() ||
+            a[i].lexeme.size() != b[i].lexeme.size()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename F>
+static double bestOf(int runs, F body) {
+    double best = 1e30;
+
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (seconds < best) best = seconds;
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 200000;
+    std::string source = generateSource(lines);
+
+    // Collect every word-shaped lexeme once
+    std::vector<std::string_view> words;
+    for (const Token& token : Lexer(source).scanTokens()) {
+        if (token.type == TokenType::IDENTIFIER ||
+            Keywords::classify(token.lexeme) != TokenType::IDENTIFIER) {
+            words.push_back(token.lexeme);
+        }
+    }
+
+    volatile long sink = 0;
+
+    double mapTime = bestOf(5, [&] {
+        long sum = 0;
+        for (std::string_view word : words) {
+            std::string text(word);
+            auto it = mapKeywords.find(text);
+            sum += (it != mapKeywords.end()) ? it->second : TokenType::IDENTIFIER;
+        }
+        sink = sink + sum;
+    });
+
+    double trieTime = bestOf(5, [&] {
+        long sum = 0;
+        for (std::string_view word : words) {
+            sum += Keywords::classify(word);
+        }
+        sink = sink + sum;
+    });
+
+    std::printf("words:                 %zu\n", words.size());
+    std::printf("unordered_map lookup:  %6.2f ns/word\n", mapTime * 1e9 / words.size());
+    std::printf("Keywords::classify:    %6.2f ns/word  (%.1fx)\n",
+                trieTime * 1e9 / words.size(), mapTime / trieTime);
+
+    std::string commented = generateCommentsAndStrings(lines);
+    const SimdScan::Level best = SimdScan::level();
+    const SimdScan::Level levels[] = {
+        SimdScan::Level::SCALAR, SimdScan::Level::SSE2, SimdScan::Level::AVX2
+    };
+
+    struct Input { const char* name; const std::string& text; };
+    for (const Input& input : {Input{"identifiers", source},
+                               Input{"comments+strings", commented}}) {
+        double megabytes = input.text.size() / (1024.0 * 1024.0);
+        SimdScan::setLevel(SimdScan::Level::SCALAR);
+        std::vector<Token> expected = Lexer(input.text).scanTokens();
+
+        std::printf("\nLexer::scanTokens on %s (%.2f MB)\n", input.name, megabytes);
+
+        for (SimdScan::Level level : levels) {
+            SimdScan::setLevel(level);
+            if (SimdScan::level() != level) continue;
+
+            if (!sameTokens(Lexer(input.text).scanTokens(), expected)) {
+                std::printf("  %-7s token stream differs from scalar!\n",
+                            SimdScan::levelName(level));
+                return 1;
+            }
+
+            double lexTime = bestOf(5, [&] {
+                Lexer lexer(input.text);
+                sink = sink + lexer.scanTokens().size();
+            });
+
+            std::printf("  %-7s %7.1f MB/s\n", SimdScan::levelName(level), megabytes / lexTime);
+        }
+    }
+
+    SimdScan::setLevel(best);
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Parser microbenchmark.
+//
+// Parses generated, expression-heavy code with the Pratt parser and
+// with the recursive-descent ladder it replaced, after checking that
+// both build the same tree. Tokens are scanned once up front so only
+// parsing is timed.
+//
+//   parser_bench [lines]
+
+#include "../src/Lexer/Lexer.h"
+#include "../src/Parser/Parser.h"
+#include "../src/Runtime/CompilationUnit.h"
+#include "../src/Runtime/FlatAst.h"
+#include "../src/Runtime/SourceBuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static std::string generateSource(int lines) {
+    static const char* operators[] = {
+        " + ", " - ", " * ", " / ", " < ", " >= ", " == ", " != ", " and ", " or "
+    };
+    const int count = sizeof(operators) / sizeof(operators[0]);
+
+    std::string source;
+    for (int i = 0; i < lines; i++) {
+        const char* a = operators[i % count];
+        const char* b = operators[(i * 7 + 3) % count];
+        const char* c = operators[(i * 3 + 1) % count];
+        std::string n = std::to_string(i);
+
+        source += "var v" + n + " = -x" + a + "(y" + b + "2.5)" + c +
+                  "f(z, !w" + a + "1)" + b + "obj.field" + c + "\"s\";\n";
+        source += "total = total" + std::string(b) + "v" + n + " * (a + b) - -c;\n";
+    }
+
+    return source;
+}
+
+static std::string printTree(std::span<Stmt* const> statements, std::string_view source) {
+    FlatAst flat = FlatAst::build(statements, source);
+
+    std::string text;
+    for (FlatAst::Index stmt : flat.list(flat.program)) {
+        text += flat.print(stmt);
+        text += "\n";
+    }
+    return text;
+}
+
+// `body` times its own region so per-run setup stays out of the result
+template <typename F>
+static double bestOf(int runs, F body) {
+    double best = 1e30;
+
+    for (int i = 0; i < runs; i++) {
+        double seconds = body();
+        if (seconds < best) best = seconds;
+    }
+
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+    CompilationUnit unit(SourceBuffer::fromString(generateSource(lines)));
+    const std::vector<Token> tokens = Lexer(unit.text()).scanTokens();
+    double megabytes = unit.text().size() / (1024.0 * 1024.0);
+
+    struct Variant { const char* name; Parser::Grammar grammar; };
+    const Variant variants[] = {
+        {"descent ladder", Parser::Grammar::LADDER},
+        {"pratt",          Parser::Grammar::PRATT}
+    };
+
+    std::string expected;
+    double times[2];
+
+    std::printf("tokens: %zu (%.2f MB)\n", tokens.size(), megabytes);
+
+    for (int i = 0; i < 2; i++) {
+        // A fresh unit per variant keeps arena growth out of the other's timing
+        CompilationUnit scratch(SourceBuffer::fromString(""));
+
+        Parser parser(tokens, scratch);
+        parser.setGrammar(variants[i].grammar);
+        std::string tree = printTree(parser.parse(), unit.text());
+
+        if (i == 0) {
+            expected = std::move(tree);
+        }
+        else if (tree != expected) {
+            std::printf("%s builds a different tree!\n", variants[i].name);
+            return 1;
+        }
+
+        times[i] = bestOf(5, [&] {
+            CompilationUnit run(SourceBuffer::fromString(""));
+            std::vector<Token> input = tokens;
+
+            auto start = std::chrono::steady_clock::now();
+            Parser timed(std::move(input), run);
+            timed.setGrammar(variants[i].grammar);
+            timed.parse();
+            auto end = std::chrono::steady_clock::now();
+
+            return std::chrono::duration<double>(end - start).count();
+        });
+    }
+
+    for (int i = 0; i < 2; i++) {
+        std::printf("%-15s %7.1f MB/s  %6.1f ns/token\n", variants[i].name,
+                    megabytes / times[i], times[i] * 1e9 / tokens.size());
+    }
+    std::printf("speedup:        %.2fx\n", times[0] / times[1]);
+
+    return 0;
+}
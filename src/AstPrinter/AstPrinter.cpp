@@ -3,17 +3,17 @@
 
 std::string AstPrinter::print(const Expr& expr) {
     Value result = expr.accept(*this);
-    if (auto s = std::get_if<std::string>(&result)) return *s;
+    if (result.isString()) return std::string(result.asString().view());
     return "(unimplemented expr)"; 
 }
 
 std::string AstPrinter::print(const Stmt& stmt) {
     Value result = stmt.accept(*this);
-    if (auto s = std::get_if<std::string>(&result)) return *s;
+    if (result.isString()) return std::string(result.asString().view());
     return "(unimplemented stmt)"; 
 }
 
-void AstPrinter::print(const std::vector<std::unique_ptr<Stmt>>& statements) {
+void AstPrinter::print(std::span<Stmt* const> statements) {
     for (const auto& stmt : statements) {
         std::cout << print(*stmt) << "\n";
     }
@@ -21,7 +21,7 @@ void AstPrinter::print(const std::vector<std::unique_ptr<Stmt>>& statements) {
 
 // ---------- Expr Visitor Implementation ---------- 
 Value AstPrinter::visitBinaryExpr(const Expr::Binary& expr) {
-    return parenthesize(expr.operator_.lexeme, {*expr.left, *expr.right});
+    return parenthesize(std::string(expr.operator_.lexeme), {*expr.left, *expr.right});
 }
 
 Value AstPrinter::visitGroupingExpr(const Expr::Grouping& expr) {
@@ -33,11 +33,11 @@ Value AstPrinter::visitLiteralExpr(const Expr::Literal& expr) {
 }
 
 Value AstPrinter::visitUnaryExpr(const Expr::Unary& expr) {
-    return parenthesize(expr.operator_.lexeme, {*expr.right});
+    return parenthesize(std::string(expr.operator_.lexeme), {*expr.right});
 }
 
 Value AstPrinter::visitVarExpr(const Expr::Variable& expr) {
-    return expr.name.lexeme;
+    return std::string(expr.name.lexeme);
 }
 
 Value AstPrinter::visitCallExpr(const Expr::Call& expr) {
@@ -48,13 +48,21 @@ Value AstPrinter::visitCallExpr(const Expr::Call& expr) {
     return result;
 }
 
+Value AstPrinter::visitThisExpr(const Expr::This& expr) {
+    return std::string(expr.keyword.lexeme);
+}
+
+Value AstPrinter::visitSuperExpr(const Expr::Super& expr) {
+    return "(super " + std::string(expr.method.lexeme) + ")";
+}
+
 // ---------- Stmt Visitor Implementation ---------- 
 Value AstPrinter::visitExpressionStmt(const Stmt::Expression& stmt) {
     return print(*stmt.expression);
 }
 
 Value AstPrinter::visitClassStmt(const Stmt::Class& stmt) {
-    std::string builder = "(class " + stmt.name.lexeme;
+    std::string builder = "(class " + std::string(stmt.name.lexeme);
 
     for (const auto& method : stmt.methods) {
         builder += " " + print(*method);
@@ -70,8 +78,8 @@ Value AstPrinter::visitPrintStmt(const Stmt::Print& stmt) {
 
 Value AstPrinter::visitVarStmt(const Stmt::Var& stmt) {
     if (stmt.initializer)
-        return parenthesize("var " + stmt.name.lexeme, {*stmt.initializer});
-    return std::string("(var " + stmt.name.lexeme + ")");
+        return parenthesize("var " + std::string(stmt.name.lexeme), {*stmt.initializer});
+    return "(var " + std::string(stmt.name.lexeme) + ")";
 }
 
 Value AstPrinter::visitBlockStmt(const Stmt::Block& stmt) {
@@ -96,7 +104,7 @@ Value AstPrinter::visitWhileStmt(const Stmt::While& stmt) {
 }
 
 Value AstPrinter::visitFunctionStmt(const Stmt::Function& stmt) {
-    std::string result = "(fun " + stmt.name.lexeme + "(";
+    std::string result = "(fun " + std::string(stmt.name.lexeme) + "(";
     for (size_t i = 0; i < stmt.params.size(); i++) {
         if (i > 0) result += " ";
         result += stmt.params[i].lexeme;
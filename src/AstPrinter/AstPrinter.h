@@ -11,7 +11,7 @@ class AstPrinter: public Expr::Visitor, Stmt::Visitor {
 public:
     std::string print(const Stmt& stmt);
     std::string print(const Expr& expr);
-    void print(const std::vector<std::unique_ptr<Stmt>>& statements);
+    void print(std::span<Stmt* const> statements);
 
     Value visitBinaryExpr(const Expr::Binary& expr) override;
     Value visitGroupingExpr(const Expr::Grouping& expr) override;
@@ -19,6 +19,8 @@ public:
     Value visitUnaryExpr(const Expr::Unary& expr) override;
     Value visitVarExpr(const Expr::Variable& expr) override;
     Value visitCallExpr(const Expr::Call& expr) override;
+    Value visitThisExpr(const Expr::This& expr) override;
+    Value visitSuperExpr(const Expr::Super& expr) override;
 
     Value visitExpressionStmt(const Stmt::Expression& stmt) override;
     Value visitClassStmt(const Stmt::Class& stmt) override;
@@ -0,0 +1,806 @@
+#include "ClosureCompiler.h"
+
+#include "../Runtime/CallDepth.h"
+#include "../Runtime/Runtime.h"
+#include "../Runtime/SymbolTable.h"
+#include "../Runtime/ValueOps.h"
+#include "../Interpreter/RuntimeError.h"
+#include "../Include/ClockCallable.h"
+#include "../Include/LoxBoundMethod.h"
+#include "../Include/LoxClass.h"
+#include "../Include/LoxInstance.h"
+
+#include <functional>
+#include <iostream>
+#include <utility>
+#include <variant>
+
+using Env = ClosureEngine::Env;
+using Scope = ClosureEngine::Scope;
+using Completion = ClosureEngine::Completion;
+using ExprFn = ClosureEngine::ExprFn;
+using StmtFn = ClosureEngine::StmtFn;
+
+// ---------- Compiled functions ----------
+Value CompiledFunction::call(Interpreter* interpreter, std::span<const Value> arguments) {
+    return callMethod(interpreter, nullptr, arguments);
+}
+
+Value CompiledFunction::callMethod(
+    Interpreter*,
+    LoxInstance* receiver,
+    std::span<const Value> arguments)
+{
+    Env frame = Heap::make<Scope>(closure, code->slotCount);
+    Heap::Root root(frame);
+
+    for (std::size_t i = 0; i < arguments.size(); i++) {
+        frame->slots[i] = arguments[i];
+    }
+
+    if (receiver != nullptr)
+        frame->slots[code->arity] = receiver;
+
+    return invoke(frame);
+}
+
+Value CompiledFunction::invoke(const Env& frame) const {
+    Value result;
+    Completion completion = code->body(frame, result);
+
+    if (code->initializer) return frame->slots[code->arity];
+    if (completion == Completion::RETURN) return result;
+    return std::monostate{};
+}
+
+// ---------- Operator closures ----------
+template <typename Op>
+static ExprFn numberBinary(ExprFn left, ExprFn right, Token operator_) {
+    return [left = std::move(left), right = std::move(right), operator_](const Env& env) -> Value {
+        Value a = left(env);
+        Value b = right(env);
+
+        if (!a.isNumber() || !b.isNumber())
+            throw RuntimeError(operator_, "Operand must be a numbers.");
+
+        return Op{}(a.asNumber(), b.asNumber());
+    };
+}
+
+// `i < 10`, `n - 1`: the right operand is a number known at compile time
+template <typename Op>
+static ExprFn numberBinaryConstant(ExprFn left, double constant, Token operator_) {
+    return [left = std::move(left), constant, operator_](const Env& env) -> Value {
+        Value a = left(env);
+
+        if (!a.isNumber())
+            throw RuntimeError(operator_, "Operand must be a numbers.");
+
+        return Op{}(a.asNumber(), constant);
+    };
+}
+
+template <typename Op>
+static ExprFn numberOperator(ExprFn left, const Expr& right, ExprFn rightFn, Token operator_) {
+    if (auto literal = dynamic_cast<const Expr::Literal*>(&right)) {
+        if (literal->value.isNumber())
+            return numberBinaryConstant<Op>(std::move(left), literal->value.asNumber(), operator_);
+    }
+
+    return numberBinary<Op>(std::move(left), std::move(rightFn), operator_);
+}
+
+static ExprFn add(ExprFn left, ExprFn right, Token operator_) {
+    return [left = std::move(left), right = std::move(right), operator_](const Env& env) -> Value {
+        Value a = left(env);
+        Value b = right(env);
+
+        if (a.isNumber()) {
+            if (b.isNumber()) return a.asNumber() + b.asNumber();
+        }
+        else if (a.isString()) {
+            if (b.isString()) return LoxString::concat(a.asString(), b.asString());
+        }
+
+        throw RuntimeError(operator_, "Operands must be two numbers or two strings.");
+    };
+}
+
+// ---------- Compiler ----------
+class ClosureEngine::Compiler : public Expr::Visitor, public Stmt::Visitor {
+public:
+    explicit Compiler(ClosureEngine& engine) : engine(engine) {}
+
+    std::vector<StmtFn> compileProgram(std::span<Stmt* const> statements) {
+        std::vector<StmtFn> program;
+        for (const Stmt* stmt : statements) program.push_back(compile(*stmt));
+        return program;
+    }
+
+    // ---------- Expressions ----------
+    Value visitLiteralExpr(const Expr::Literal& expr) override {
+        exprResult = [value = expr.value](const Env&) -> Value { return value; };
+        return std::monostate{};
+    }
+
+    Value visitGroupingExpr(const Expr::Grouping& expr) override {
+        exprResult = compile(*expr.expression);
+        return std::monostate{};
+    }
+
+    Value visitUnaryExpr(const Expr::Unary& expr) override {
+        ExprFn right = compile(*expr.right);
+
+        if (expr.operator_.type == MINUS) {
+            exprResult = [right = std::move(right), operator_ = expr.operator_](const Env& env) -> Value {
+                Value value = right(env);
+
+                if (!value.isNumber())
+                    throw RuntimeError(operator_, "Operand must be a number.");
+
+                return -value.asNumber();
+            };
+        }
+        else {
+            exprResult = [right = std::move(right)](const Env& env) -> Value {
+                return !ValueOps::isTruthy(right(env));
+            };
+        }
+
+        return std::monostate{};
+    }
+
+    Value visitBinaryExpr(const Expr::Binary& expr) override {
+        ExprFn left = compile(*expr.left);
+        ExprFn right = compile(*expr.right);
+        const Token& op = expr.operator_;
+
+        switch (op.type) {
+            case GREATER:
+                exprResult = numberOperator<std::greater<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case GREATER_EQUAL:
+                exprResult = numberOperator<std::greater_equal<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case LESS:
+                exprResult = numberOperator<std::less<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case LESS_EQUAL:
+                exprResult = numberOperator<std::less_equal<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case MINUS:
+                exprResult = numberOperator<std::minus<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case STAR:
+                exprResult = numberOperator<std::multiplies<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case SLASH:
+                exprResult = numberOperator<std::divides<>>(std::move(left), *expr.right, std::move(right), op);
+                break;
+            case PLUS:
+                exprResult = add(std::move(left), std::move(right), op);
+                break;
+            case EQUAL_EQUAL:
+                exprResult = [left = std::move(left), right = std::move(right)](const Env& env) -> Value {
+                    Value a = left(env);
+                    Heap::Root root(a);
+                    return ValueOps::isEqual(a, right(env));
+                };
+                break;
+            case BANG_EQUAL:
+                exprResult = [left = std::move(left), right = std::move(right)](const Env& env) -> Value {
+                    Value a = left(env);
+                    Heap::Root root(a);
+                    return !ValueOps::isEqual(a, right(env));
+                };
+                break;
+            default:
+                exprResult = [](const Env&) -> Value { return std::monostate{}; };
+                break;
+        }
+
+        return std::monostate{};
+    }
+
+    Value visitLogicalExpr(const Expr::Logical& expr) override {
+        ExprFn left = compile(*expr.left);
+        ExprFn right = compile(*expr.right);
+
+        if (expr.operator_.type == OR) {
+            exprResult = [left = std::move(left), right = std::move(right)](const Env& env) -> Value {
+                Value value = left(env);
+                if (ValueOps::isTruthy(value)) return value;
+                return right(env);
+            };
+        }
+        else {
+            exprResult = [left = std::move(left), right = std::move(right)](const Env& env) -> Value {
+                Value value = left(env);
+                if (!ValueOps::isTruthy(value)) return value;
+                return right(env);
+            };
+        }
+
+        return std::monostate{};
+    }
+
+    Value visitVarExpr(const Expr::Variable& expr) override {
+        exprResult = read(expr.name);
+        return std::monostate{};
+    }
+
+    Value visitAssignExpr(const Expr::Assign& expr) override {
+        exprResult = write(expr.name, compile(*expr.value));
+        return std::monostate{};
+    }
+
+    Value visitCallExpr(const Expr::Call& expr) override {
+        std::vector<ExprFn> arguments;
+        for (const Expr* argument : expr.arguments) {
+            arguments.push_back(compile(*argument));
+        }
+
+        // Likewise super.name(...), on `this`
+        if (expr.superMethod != nullptr) {
+            const Expr::Super& super = *expr.superMethod;
+
+            exprResult = [superclass = read(super.keyword), receiver = readThis(super.keyword),
+                          arguments = std::move(arguments), paren = expr.paren,
+                          &super, &depth = engine.callDepth](const Env& env) -> Value {
+                LoxCallable* method = superMethod(super, superclass(env));
+                return call(method, receiver(env).asInstance(), arguments, env, paren, depth);
+            };
+
+            return std::monostate{};
+        }
+
+        // obj.name(...) runs a method without binding it to obj first
+        if (expr.property != nullptr) {
+            const Expr::Get& property = *expr.property;
+
+            exprResult = [receiver = compile(*property.receiver), arguments = std::move(arguments),
+                          paren = expr.paren, name = property.name, methodCache = &expr.cache,
+                          fieldCache = &property.cache, &depth = engine.callDepth](const Env& env) -> Value {
+                Value object = receiver(env);
+
+                if (!object.isInstance())
+                    throw RuntimeError(name, "Only instances have properties.");
+
+                LoxInstance* instance = object.asInstance();
+                LoxCallable* method = instance->method(name, *methodCache);
+
+                // A field holding something callable, or no such property
+                if (method == nullptr) {
+                    Value callee = instance->get(name, *fieldCache);
+                    Heap::Root calleeRoot(callee);
+                    return call(callee, nullptr, arguments, env, paren, depth);
+                }
+
+                Heap::Root receiverRoot(object);
+                return call(method, instance, arguments, env, paren, depth);
+            };
+
+            return std::monostate{};
+        }
+
+        exprResult = [callee = compile(*expr.callee), arguments = std::move(arguments),
+                      paren = expr.paren, &depth = engine.callDepth](const Env& env) -> Value {
+            Value calleeValue = callee(env);
+            Heap::Root calleeRoot(calleeValue);
+            return call(calleeValue, nullptr, arguments, env, paren, depth);
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitThisExpr(const Expr::This& expr) override {
+        exprResult = read(expr.keyword);
+        return std::monostate{};
+    }
+
+    Value visitSuperExpr(const Expr::Super& expr) override {
+        exprResult = [superclass = read(expr.keyword), receiver = readThis(expr.keyword),
+                      &expr](const Env& env) -> Value {
+            LoxCallable* method = superMethod(expr, superclass(env));
+            return Heap::make<LoxBoundMethod>(receiver(env).asInstance(), method);
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitGetExpr(const Expr::Get& expr) override {
+        exprResult = [receiver = compile(*expr.receiver), name = expr.name,
+                      cache = &expr.cache](const Env& env) -> Value {
+            Value object = receiver(env);
+
+            if (object.isInstance())
+                return object.asInstance()->get(name, *cache);
+
+            throw RuntimeError(name, "Only instances have properties.");
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitSetExpr(const Expr::Set& expr) override {
+        exprResult = [receiver = compile(*expr.receiver), value = compile(*expr.value),
+                      name = expr.name, cache = &expr.cache](const Env& env) -> Value {
+            Value object = receiver(env);
+
+            if (!object.isInstance())
+                throw RuntimeError(name, "Only instances have fields.");
+
+            Heap::Root root(object);
+            Value assigned = value(env);
+            object.asInstance()->set(name, assigned, *cache);
+            return assigned;
+        };
+
+        return std::monostate{};
+    }
+
+    // ---------- Statements ----------
+    Value visitExpressionStmt(const Stmt::Expression& stmt) override {
+        stmtResult = [expression = compile(*stmt.expression)](const Env& env, Value&) {
+            expression(env);
+            return Completion::NORMAL;
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitPrintStmt(const Stmt::Print& stmt) override {
+        stmtResult = [expression = compile(*stmt.expression)](const Env& env, Value&) {
+            std::cout << ValueOps::stringify(expression(env)) << '\n';
+            return Completion::NORMAL;
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitVarStmt(const Stmt::Var& stmt) override {
+        ExprFn initializer = stmt.initializer != nullptr
+            ? compile(*stmt.initializer)
+            : ExprFn([](const Env&) -> Value { return std::monostate{}; });
+
+        stmtResult = define(stmt.name, std::move(initializer));
+        return std::monostate{};
+    }
+
+    Value visitBlockStmt(const Stmt::Block& stmt) override {
+        // Blocks that declare nothing run in the enclosing scope
+        if (!declaresAnything(stmt.statements)) {
+            stmtResult = compileSequence(stmt.statements);
+            return std::monostate{};
+        }
+
+        scopes.emplace_back();
+        StmtFn body = compileSequence(stmt.statements);
+        std::size_t size = scopes.back().size();
+        scopes.pop_back();
+
+        stmtResult = [body = std::move(body), size](const Env& env, Value& result) {
+            Env inner = Heap::make<Scope>(env, size);
+            Heap::Root root(inner);
+            return body(inner, result);
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitIfStmt(const Stmt::If& stmt) override {
+        ExprFn condition = compile(*stmt.condition);
+        StmtFn thenBranch = compile(*stmt.thenBranch);
+
+        if (stmt.elseBranch == nullptr) {
+            stmtResult = [condition = std::move(condition), thenBranch = std::move(thenBranch)]
+                         (const Env& env, Value& result) {
+                if (ValueOps::isTruthy(condition(env))) return thenBranch(env, result);
+                return Completion::NORMAL;
+            };
+        }
+        else {
+            stmtResult = [condition = std::move(condition), thenBranch = std::move(thenBranch),
+                          elseBranch = compile(*stmt.elseBranch)](const Env& env, Value& result) {
+                if (ValueOps::isTruthy(condition(env))) return thenBranch(env, result);
+                return elseBranch(env, result);
+            };
+        }
+
+        return std::monostate{};
+    }
+
+    Value visitWhileStmt(const Stmt::While& stmt) override {
+        stmtResult = [condition = compile(*stmt.condition), body = compile(*stmt.body)]
+                     (const Env& env, Value& result) {
+            while (ValueOps::isTruthy(condition(env))) {
+                if (body(env, result) == Completion::RETURN) return Completion::RETURN;
+            }
+
+            return Completion::NORMAL;
+        };
+
+        return std::monostate{};
+    }
+
+    Value visitFunctionStmt(const Stmt::Function& stmt) override {
+        // Declared before its body so the body can call it
+        Binding binding = declare(stmt.name);
+
+        ExprFn makeClosure = [code = compileFunction(stmt, false)](const Env& env) -> Value {
+            return Heap::make<CompiledFunction>(code, env);
+        };
+
+        stmtResult = store(binding, std::move(makeClosure));
+        return std::monostate{};
+    }
+
+    Value visitReturnStmt(const Stmt::Return& stmt) override {
+        if (stmt.value == nullptr) {
+            stmtResult = [](const Env&, Value& result) {
+                result = std::monostate{};
+                return Completion::RETURN;
+            };
+        }
+        else {
+            stmtResult = [value = compile(*stmt.value)](const Env& env, Value& result) {
+                result = value(env);
+                return Completion::RETURN;
+            };
+        }
+
+        return std::monostate{};
+    }
+
+    Value visitClassStmt(const Stmt::Class& stmt) override {
+        // Declared before the methods so they can refer to the class
+        Binding binding = declare(stmt.name);
+
+        // The methods run inside one more scope, holding `super`
+        ExprFn superclass;
+        if (stmt.superclass != nullptr) {
+            static const int super = SymbolTable::intern("super");
+
+            superclass = compile(*stmt.superclass);
+            scopes.emplace_back(1, super);
+        }
+
+        std::vector<std::pair<int, Ref<const FunctionCode>>> methods;
+        for (const Stmt::Function* method : stmt.methods) {
+            methods.emplace_back(method->name.symbol, compileFunction(*method, true));
+        }
+
+        if (superclass) scopes.pop_back();
+
+        ExprFn makeClass = [name = std::string(stmt.name.lexeme),
+                            superclass = std::move(superclass),
+                            superName = stmt.superclass ? stmt.superclass->name : stmt.name,
+                            methods = std::move(methods)](const Env& env) -> Value {
+            auto klass = Heap::make<LoxClass>(name);
+            Heap::Root root(klass);
+
+            Env methodEnv = env;
+            if (superclass) {
+                Value value = superclass(env);
+                auto parent = value.isCallable() ? dynamic_cast<LoxClass*>(value.asCallable())
+                                                 : nullptr;
+
+                if (parent == nullptr)
+                    throw RuntimeError(superName, "Superclass must be a class.");
+
+                klass->inherit(*parent);
+
+                methodEnv = Heap::make<Scope>(env, 1);
+                methodEnv->slots[0] = std::move(value);
+            }
+            Heap::Root scopeRoot(methodEnv);
+
+            for (const auto& [symbol, code] : methods) {
+                klass->addMethod(symbol, Heap::make<CompiledFunction>(code, methodEnv));
+            }
+
+            return klass;
+        };
+
+        stmtResult = store(binding, std::move(makeClass));
+        return std::monostate{};
+    }
+
+private:
+    // Where a declared name lives
+    struct Binding {
+        bool global;
+        int symbol;
+        int slot;
+    };
+
+    ClosureEngine& engine;
+
+    // Names declared so far in each enclosing scope; a name's slot is
+    // its position in its scope
+    std::vector<std::vector<int>> scopes;
+
+    ExprFn exprResult;
+    StmtFn stmtResult;
+
+    ExprFn compile(const Expr& expr) {
+        expr.accept(*this);
+        return std::move(exprResult);
+    }
+
+    StmtFn compile(const Stmt& stmt) {
+        stmt.accept(*this);
+        return std::move(stmtResult);
+    }
+
+    StmtFn compileSequence(std::span<Stmt* const> statements) {
+        std::vector<StmtFn> compiled;
+        for (const Stmt* stmt : statements) compiled.push_back(compile(*stmt));
+
+        if (compiled.size() == 1) return std::move(compiled.front());
+
+        return [compiled = std::move(compiled)](const Env& env, Value& result) {
+            for (const StmtFn& stmt : compiled) {
+                if (stmt(env, result) == Completion::RETURN) return Completion::RETURN;
+            }
+
+            return Completion::NORMAL;
+        };
+    }
+
+    // A method's scope declares `this` after the parameters
+    Ref<const FunctionCode> compileFunction(const Stmt::Function& stmt, bool method) {
+        static const int self = SymbolTable::intern("this");
+
+        auto code = Ref<FunctionCode>::make();
+        code->name = std::string(stmt.name.lexeme);
+        code->arity = static_cast<int>(stmt.params.size());
+        code->initializer = stmt.initializer;
+
+        scopes.emplace_back();
+        for (const Token& param : stmt.params) {
+            scopes.back().push_back(param.symbol);
+        }
+        if (method) scopes.back().push_back(self);
+
+        code->body = compileSequence(stmt.body);
+        code->slotCount = scopes.back().size();
+        scopes.pop_back();
+
+        return code;
+    }
+
+    // `this` as seen from where `near` is, inside a method
+    ExprFn readThis(const Token& near) {
+        static const int self = SymbolTable::intern("this");
+
+        Token keyword(TokenType::THIS, "this", near.line);
+        keyword.symbol = self;
+        return read(keyword);
+    }
+
+    // The superclass's method `super.name` refers to; `superclass` is
+    // the value of `super`, which only ever holds a class
+    static LoxCallable* superMethod(const Expr::Super& expr, const Value& superclass) {
+        auto klass = static_cast<LoxClass*>(superclass.asCallable());
+        LoxCallable* method = klass->findMethod(expr.method.symbol, expr.cache);
+
+        if (method == nullptr) {
+            throw RuntimeError(expr.method,
+                               "Undefined property '" + std::string(expr.method.lexeme) + "'.");
+        }
+
+        return method;
+    }
+
+    // Call `callable` (null if the callee is not callable) on the values
+    // of `arguments`, with `receiver` as `this` when it is a method,
+    // counting it in the engine's call `depth`. Our own functions get
+    // their frame filled in directly
+    static Value call(LoxCallable* callable, LoxInstance* receiver,
+                      const std::vector<ExprFn>& arguments, const Env& env, const Token& paren,
+                      int& depth) {
+        if (callable != nullptr) {
+            auto function = dynamic_cast<CompiledFunction*>(callable);
+            if (function != nullptr &&
+                static_cast<std::size_t>(function->code->arity) == arguments.size()) {
+                Env frame = Heap::make<Scope>(function->closure, function->code->slotCount);
+                Heap::Root frameRoot(frame);
+
+                for (std::size_t i = 0; i < arguments.size(); i++) {
+                    frame->slots[i] = arguments[i](env);
+                }
+
+                if (receiver != nullptr)
+                    frame->slots[arguments.size()] = receiver;
+
+                CallDepth guard(depth, paren);
+                return function->invoke(frame);
+            }
+        }
+
+        std::vector<Value> values;
+        Heap::Root valuesRoot(values);
+        values.reserve(arguments.size());
+        for (const ExprFn& argument : arguments) {
+            values.push_back(argument(env));
+        }
+
+        if (callable == nullptr)
+            throw RuntimeError(paren, "Can only call function and classes.");
+
+        if (values.size() != static_cast<std::size_t>(callable->arity())) {
+            throw RuntimeError(paren,
+                               "Expected " + std::to_string(callable->arity()) +
+                               " arguments but got " +
+                               std::to_string(values.size()) + ".");
+        }
+
+        CallDepth guard(depth, paren);
+        if (receiver != nullptr)
+            return callable->callMethod(nullptr, receiver, values);
+
+        return callable->call(nullptr, values);
+    }
+
+    static Value call(const Value& callee, LoxInstance* receiver,
+                      const std::vector<ExprFn>& arguments, const Env& env, const Token& paren,
+                      int& depth) {
+        return call(callee.isCallable() ? callee.asCallable() : nullptr,
+                    receiver, arguments, env, paren, depth);
+    }
+
+    static bool declaresAnything(std::span<Stmt* const> statements) {
+        for (const Stmt* stmt : statements) {
+            if (dynamic_cast<const Stmt::Var*>(stmt) != nullptr ||
+                dynamic_cast<const Stmt::Function*>(stmt) != nullptr ||
+                dynamic_cast<const Stmt::Class*>(stmt) != nullptr)
+                return true;
+        }
+
+        return false;
+    }
+
+    // ---------- Variables ----------
+    Binding declare(const Token& name) {
+        if (scopes.empty()) return {true, name.symbol, 0};
+
+        scopes.back().push_back(name.symbol);
+        return {false, name.symbol, static_cast<int>(scopes.back().size() - 1)};
+    }
+
+    StmtFn store(const Binding& binding, ExprFn value) {
+        if (binding.global) {
+            return [&globals = engine.globals, symbol = binding.symbol,
+                    value = std::move(value)](const Env& env, Value&) {
+                globals[symbol] = {value(env), true};
+                return Completion::NORMAL;
+            };
+        }
+
+        return [slot = binding.slot, value = std::move(value)](const Env& env, Value&) {
+            env->slots[slot] = value(env);
+            return Completion::NORMAL;
+        };
+    }
+
+    // The value is computed before the name comes into scope, matching
+    // the Resolver, which rejects reads of it in its own initializer
+    StmtFn define(const Token& name, ExprFn value) {
+        return store(declare(name), std::move(value));
+    }
+
+    // Innermost declaration of `symbol` so far, as (depth, slot)
+    bool resolve(int symbol, int& depth, int& slot) const {
+        for (int i = static_cast<int>(scopes.size()) - 1; i >= 0; i--) {
+            const std::vector<int>& scope = scopes[i];
+
+            for (int j = static_cast<int>(scope.size()) - 1; j >= 0; j--) {
+                if (scope[j] == symbol) {
+                    depth = static_cast<int>(scopes.size()) - 1 - i;
+                    slot = j;
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    static Scope* ancestor(Scope* scope, int depth) {
+        for (int i = 0; i < depth; i++) scope = scope->enclosing;
+        return scope;
+    }
+
+    ExprFn read(const Token& name) {
+        int depth, slot;
+        if (!resolve(name.symbol, depth, slot)) {
+            return [&globals = engine.globals, name](const Env&) -> Value {
+                const Global& global = globals[name.symbol];
+                if (!global.defined) {
+                    throw RuntimeError(name,
+                                       "Undefined variable '" + std::string(name.lexeme) + "'.");
+                }
+
+                return global.value;
+            };
+        }
+
+        if (depth == 0) {
+            return [slot](const Env& env) -> Value { return env->slots[slot]; };
+        }
+
+        if (depth == 1) {
+            return [slot](const Env& env) -> Value { return env->enclosing->slots[slot]; };
+        }
+
+        return [depth, slot](const Env& env) -> Value {
+            return ancestor(env, depth)->slots[slot];
+        };
+    }
+
+    ExprFn write(const Token& name, ExprFn value) {
+        int depth, slot;
+        if (!resolve(name.symbol, depth, slot)) {
+            return [&globals = engine.globals, name, value = std::move(value)](const Env& env) -> Value {
+                Value assigned = value(env);
+
+                Global& global = globals[name.symbol];
+                if (!global.defined) {
+                    throw RuntimeError(name,
+                                       "Undefined variable '" + std::string(name.lexeme) + "'.");
+                }
+
+                global.value = assigned;
+                return assigned;
+            };
+        }
+
+        if (depth == 0) {
+            return [slot, value = std::move(value)](const Env& env) -> Value {
+                Value assigned = value(env);
+                env->slots[slot] = assigned;
+                return assigned;
+            };
+        }
+
+        return [depth, slot, value = std::move(value)](const Env& env) -> Value {
+            Value assigned = value(env);
+            ancestor(env, depth)->slots[slot] = assigned;
+            return assigned;
+        };
+    }
+};
+
+// ---------- Engine ----------
+ClosureEngine::ClosureEngine() {
+    int clock = SymbolTable::intern("clock");
+    globals.resize(clock + 1);
+    globals[clock] = {Value(Heap::make<ClockCallable>()), true};
+}
+
+void ClosureEngine::markRoots() {
+    for (const Global& global : globals)
+        Heap::mark(global.value);
+}
+
+void ClosureEngine::interpret(std::span<Stmt* const> statements) {
+    // Every name the program can mention was interned while lexing it
+    if (globals.size() < SymbolTable::size())
+        globals.resize(SymbolTable::size());
+
+    Compiler compiler(*this);
+    std::vector<StmtFn> program = compiler.compileProgram(statements);
+
+    Env global = nullptr;
+    Value result;
+
+    try {
+        for (const StmtFn& stmt : program) {
+            stmt(global, result);
+        }
+    }
+    catch (const RuntimeError& error) {
+        Runtime::runtimeError(error);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../Runtime/Expr.h"
+#include "../Runtime/Stmt.h"
+#include "../Runtime/Heap.h"
+#include "../Runtime/Ref.h"
+#include "../Runtime/Value.h"
+#include "../Include/LoxCallable.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Execution engine that walks the resolved AST once and turns every
+// node into a pre-linked C++ closure. Variable references are bound to
+// a (depth, slot) pair or a global index at compile time and operators
+// to a lambda for that operator, so running a program never visits a
+// node, hashes a name or switches on a TokenType.
+//
+// Runtime scopes are fixed-size slot arrays on the Heap. A block only
+// gets one if it declares something, and a call gets exactly one for
+// its parameters and top-level body declarations. The scope a closure
+// runs in is rooted by whoever created it for as long as it runs.
+class ClosureEngine {
+public:
+    struct Scope : GcObject {
+        Scope* enclosing;
+        std::vector<Value> slots;
+
+        Scope(Scope* enclosing, std::size_t size)
+            : enclosing(enclosing), slots(size) {}
+
+        void trace() const override {
+            Heap::mark(enclosing);
+            for (const Value& slot : slots) Heap::mark(slot);
+        }
+    };
+
+    // Null at the top level, where every name is a global
+    using Env = Scope*;
+
+    // How a statement finished; a RETURN leaves its value in `result`
+    enum class Completion { NORMAL, RETURN };
+
+    using ExprFn = std::function<Value(const Env& env)>;
+    using StmtFn = std::function<Completion(const Env& env, Value& result)>;
+
+    // A compiled function body, shared by every closure over it. A
+    // method's receiver goes in the slot after the parameters
+    struct FunctionCode : RefCounted<FunctionCode> {
+        std::string name;
+        int arity = 0;
+        std::size_t slotCount = 0;
+        // `init`, which returns its receiver
+        bool initializer = false;
+        StmtFn body;
+    };
+
+    ClosureEngine();
+    ClosureEngine(const ClosureEngine&) = delete;
+    ClosureEngine& operator=(const ClosureEngine&) = delete;
+
+    // Compile and run; runtime errors are reported through Runtime
+    void interpret(std::span<Stmt* const> statements);
+
+private:
+    struct Global {
+        Value value;
+        bool defined = false;
+    };
+
+    // Indexed by SymbolTable id; persists across REPL lines
+    std::vector<Global> globals;
+    // Calls in progress, bounded by CallDepth::MAX
+    int callDepth = 0;
+
+    class Compiler;
+
+    void markRoots();
+
+    Heap::Roots roots{[this] { markRoots(); }};
+};
+
+// Function value produced by the closure engine
+class CompiledFunction : public LoxCallable {
+public:
+    Ref<const ClosureEngine::FunctionCode> code;
+    ClosureEngine::Env closure;
+
+    CompiledFunction(Ref<const ClosureEngine::FunctionCode> code,
+                     ClosureEngine::Env closure)
+        : code(std::move(code)), closure(closure) {}
+
+    int arity() const override {
+        return code->arity;
+    }
+
+    Value call(Interpreter* interpreter, std::span<const Value> arguments) override;
+    Value callMethod(Interpreter* interpreter,
+                     LoxInstance* receiver,
+                     std::span<const Value> arguments) override;
+
+    // Run the body in a scope whose parameter (and receiver) slots are
+    // filled in
+    Value invoke(const ClosureEngine::Env& frame) const;
+
+    std::string toString() const override {
+        return "<fn " + code->name + ">";
+    }
+
+    void trace() const override {
+        Heap::mark(closure);
+    }
+};
@@ -2,7 +2,7 @@
 
 #include "LoxCallable.h"
 #include <chrono>
-#include <vector>
+#include <span>
 
 class ClockCallable : public LoxCallable {
 public:
@@ -11,7 +11,7 @@ public:
     }
 
     Value call(Interpreter*,
-               const std::vector<Value>&) override 
+               std::span<const Value>) override 
     {
         using namespace std::chrono;
         auto now = system_clock::now().time_since_epoch();
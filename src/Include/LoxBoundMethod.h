@@ -0,0 +1,32 @@
+#pragma once
+
+#include "LoxCallable.h"
+
+#include <string>
+#include <span>
+
+// A method read off an instance as a value, `var f = obj.method;`,
+// remembering the instance to call it on. Calling the method on the
+// spot, `obj.method()`, skips creating one.
+class LoxBoundMethod : public LoxCallable {
+public:
+    LoxInstance* receiver;
+    LoxCallable* method;
+
+    LoxBoundMethod(LoxInstance* receiver, LoxCallable* method)
+        : receiver(receiver), method(method) {}
+
+    Value call(Interpreter* interpreter, std::span<const Value> arguments) override {
+        return method->callMethod(interpreter, receiver, arguments);
+    }
+
+    int arity() const override {
+        return method->arity();
+    }
+
+    std::string toString() const override {
+        return method->toString();
+    }
+
+    void trace() const override;
+};
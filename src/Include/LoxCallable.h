@@ -3,15 +3,26 @@
 #include "../Runtime/Value.h"
 #include "../Include/LoxObject.h"
 
-#include <vector>
+#include <span>
 #include <string>
 
 class Interpreter;
+class LoxInstance;
 
 class LoxCallable : public LoxObject {
 public:
+    // `arguments` views the caller's own storage, usually the engine's
+    // value stack, and is only valid until the callee runs Lox code
     virtual Value call(Interpreter* interpreter,
-                       const std::vector<Value>& arguments) = 0;
+                       std::span<const Value> arguments) = 0;
+
+    // Call as a method of `receiver`, which the body sees as `this`.
+    // Only the engines' function types have a `this` to bind
+    virtual Value callMethod(Interpreter* interpreter,
+                             LoxInstance* /*receiver*/,
+                             std::span<const Value> arguments) {
+        return call(interpreter, arguments);
+    }
 
     virtual int arity() const = 0; 
     virtual std::string toString() const = 0;
@@ -1,28 +1,72 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <memory>
+#include <unordered_map>
 #include "../Include/LoxCallable.h"
+#include "../Runtime/Shape.h"
 
 class LoxInstance;  
 
+// Every instance points at its one class object, which holds the
+// methods: each engine's own function type, resolved by name once per
+// call site and then cached there.
 class LoxClass : public LoxCallable {
 public:
     std::string name;
+    // Keyed by SymbolTable id
+    std::unordered_map<int, LoxCallable*> methods;
+    // methods["init"], which every construction runs
+    LoxCallable* initializer = nullptr;
+    // Unlike the address, never reused by a later class
+    const std::uint64_t id;
 
     LoxClass(std::string name)
-        : name(std::move(name)) {}
+        : name(std::move(name)), id(++classCount) {}
 
+    // Copy down the superclass's methods before adding the class's own,
+    // which replace any of the same name. Lookups then never walk a
+    // chain of superclasses
+    void inherit(const LoxClass& superclass) {
+        methods = superclass.methods;
+        initializer = superclass.initializer;
+    }
+
+    void addMethod(int symbol, LoxCallable* method);
+
+    LoxCallable* findMethod(int symbol) const {
+        auto it = methods.find(symbol);
+        return it == methods.end() ? nullptr : it->second;
+    }
+
+    // For a site that always asks this class's table, `super.name`
+    LoxCallable* findMethod(int symbol, MethodCache& cache) const {
+        if (LoxCallable* method = cache.find(id, nullptr))
+            return method;
+
+        LoxCallable* method = findMethod(symbol);
+        if (method != nullptr) cache.add(id, nullptr, method);
+        return method;
+    }
+
+    // A new instance, passed through the initializer if there is one
     Value call(
         Interpreter* interpreter,
-        const std::vector<Value>& arguments
+        std::span<const Value> arguments
     ) override;
 
     int arity() const override {
-        return 0;
+        return initializer != nullptr ? initializer->arity() : 0;
     }
 
     std::string toString() const override {
         return name;
     }
+
+    void trace() const override {
+        for (const auto& [symbol, method] : methods) Heap::mark(method);
+    }
+
+private:
+    static inline std::uint64_t classCount = 0;
 };
@@ -2,52 +2,47 @@
 
 #include "LoxCallable.h"
 #include "../Runtime/Stmt.h"
-#include "../Runtime/Return.h"
 #include "../Semantic/Environment.h"
 #include "../Interpreter/Interpreter.h"
 
-#include <memory>
+#include <span>
 #include <string>
 #include <variant>
+#include <vector>
 
+// A closure holds only the variables its body uses: copies of those
+// that never change once captured, and shared cells for the rest
 class LoxFunction : public LoxCallable {
 public:
     const Stmt::Function* declaration;
-    std::shared_ptr<Environment> closure;
+    // Indexed by UPVALUE / UPVALUE_CELL bindings in the body
+    std::vector<Value> captured;
+    std::vector<Cell*> capturedCells;
 
-    LoxFunction(const Stmt::Function* declaration,
-                std::shared_ptr<Environment> closure)
-    : declaration(declaration), closure(closure) {}
+    LoxFunction(const Stmt::Function* declaration)
+    : declaration(declaration) {}
 
     int arity() const override {
         return declaration->params.size();
     }
 
-    Value call(Interpreter* interpreter, const std::vector<Value>& arguments) override { 
-        std::shared_ptr<Environment> environment = 
-            std::make_shared<Environment>(closure);
-
-        for (int i=0; i < declaration->params.size(); i++) {
-            environment->define(
-                declaration->params[i].lexeme,
-                arguments[i]);
-        }
-        
-        try {
-            interpreter->executeBlock(
-                declaration->body,
-                environment
-            );
-        }
-        catch (Return returnValue) {
-            return returnValue.value;
-        }
-
-        return std::monostate{};
+    Value call(Interpreter* interpreter, std::span<const Value> arguments) override { 
+        return interpreter->call(*this, arguments);
     };
 
+    Value callMethod(Interpreter* interpreter,
+                     LoxInstance* receiver,
+                     std::span<const Value> arguments) override {
+        return interpreter->call(*this, arguments, receiver);
+    }
+
+    void trace() const override {
+        for (const Value& value : captured) Heap::mark(value);
+        for (const Cell* cell : capturedCells) Heap::mark(cell);
+    }
+
 private:
     std::string toString() const override {
-        return "<fn " + declaration->name.lexeme + ">";
+        return "<fn " + std::string(declaration->name.lexeme) + ">";
     }
 };
@@ -1,29 +1,89 @@
+#include "LoxBoundMethod.h"
 #include "LoxClass.h"
 #include "LoxInstance.h"
+#include "../Runtime/SymbolTable.h"
+
+// ---------- LoxClass ----------
+void LoxClass::addMethod(int symbol, LoxCallable* method) {
+    static const int init = SymbolTable::intern("init");
+
+    methods[symbol] = method;
+    if (symbol == init) initializer = method;
+}
 
 Value LoxClass::call(
-    Interpreter*,
-    const std::vector<Value>&
+    Interpreter* interpreter,
+    std::span<const Value> arguments
 ) {
-    auto instance = std::make_shared<LoxInstance>(
-        std::make_shared<LoxClass>(*this)
-    );
+    auto instance = Heap::make<LoxInstance>(this);
+
+    if (initializer != nullptr) {
+        Heap::Root root(instance);
+        initializer->callMethod(interpreter, instance, arguments);
+    }
+
     return instance;
 }
 
-Value LoxInstance::get(const Token& name) {
-    if (fields.count(name.lexeme)) {
-        return fields[name.lexeme];
+void LoxBoundMethod::trace() const {
+    Heap::mark(receiver);
+    Heap::mark(method);
+}
+
+// ---------- LoxInstance ----------
+Value LoxInstance::getSlow(const Token& name, PropertyCache& cache) {
+    int slot = shape->slotOf(name.symbol);
+
+    if (slot >= 0) {
+        cache.add(shape, shape, slot);
+        return field(slot);
     }
 
+    if (LoxCallable* method = klass->findMethod(name.symbol))
+        return Heap::make<LoxBoundMethod>(this, method);
+
     throw RuntimeError(name, 
-                       "Undefined property '" + name.lexeme + "'.");
+                       "Undefined property '" + std::string(name.lexeme) + "'.");
+}
+
+void LoxInstance::setSlow(const Token& name, const Value& value, PropertyCache& cache) {
+    const Shape* from = shape;
+    int slot = shape->slotOf(name.symbol);
+
+    if (slot < 0) {
+        slot = shape->size();
+        moveTo(shape->adding(name.symbol));
+    }
+
+    cache.add(from, shape, slot);
+    field(slot) = value;
+}
+
+LoxCallable* LoxInstance::methodSlow(const Token& name, MethodCache& cache) const {
+    if (shape->slotOf(name.symbol) >= 0) return nullptr;
+
+    LoxCallable* method = klass->findMethod(name.symbol);
+    if (method != nullptr) cache.add(klass->id, shape, method);
+
+    return method;
 }
 
-void LoxInstance::set(const Token& name, const Value& value) {
-    fields[name.lexeme] = value;
+// Adopt a shape with one more field than the current one
+void LoxInstance::moveTo(const Shape* next) {
+    shape = next;
+
+    if (shape->size() > INLINE_FIELDS)
+        moreFields.resize(shape->size() - INLINE_FIELDS);
 }
 
 std::string LoxInstance::toString() const {
     return klass->name + " instance";
 }
+
+void LoxInstance::trace() const {
+    Heap::mark(klass);
+
+    for (int slot = 0; slot < shape->size(); slot++) {
+        Heap::mark(field(slot));
+    }
+}
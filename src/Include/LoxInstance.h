@@ -1,27 +1,89 @@
 #pragma once
 
+#include "LoxClass.h"
 #include "LoxObject.h"
 #include "../Token/Token.h"
+#include "../Runtime/Shape.h"
 #include "../Runtime/Value.h"
 #include "../Interpreter/RuntimeError.h"
 
-#include <memory>
 #include <string>
-#include <unordered_map>
-
-class LoxClass;  
+#include <vector>
 
 class LoxInstance : public LoxObject {
 public:
-    LoxInstance(std::shared_ptr<LoxClass> klass)
-        : klass(std::move(klass)) {}
+    LoxInstance(LoxClass* klass)
+        : klass(klass) {}
+
+    // `cache` belongs to the access site; a hit is a shape compare and
+    // an indexed load or store. Reading a method binds it to this
+    // instance
+    Value get(const Token& name, PropertyCache& cache);
+    void set(const Token& name, const Value& value, PropertyCache& cache);
+
+    // The method to run for `this.name(...)`, or null when there is no
+    // such method or a field of that name shadows it; get() then finds
+    // the callee or reports the missing property
+    LoxCallable* method(const Token& name, MethodCache& cache) const;
+
+    // The method `cache` has for this instance's class and shape, if any
+    LoxCallable* cachedMethod(const MethodCache& cache) const {
+        return cache.find(klass->id, shape);
+    }
 
-    Value get(const Token& name);
-    void set(const Token& name, const Value& value);
+    // The field `cache` has a slot for in this instance's shape, if any;
+    // lets the VM skip building a name on a hit
+    const Value* cached(const PropertyCache& cache) const {
+        const PropertyCache::Entry* entry = cache.find(shape);
+        return entry ? &field(entry->slot) : nullptr;
+    }
 
     std::string toString() const override;
+    void trace() const override;
 
 private:
-    std::shared_ptr<LoxClass> klass;
-    std::unordered_map<std::string, Value> fields;
+    // Slots stored in the object itself; the rest go in `moreFields`
+    static constexpr int INLINE_FIELDS = 4;
+
+    LoxClass* klass;
+    const Shape* shape = Shape::empty();
+    Value fields[INLINE_FIELDS];
+    std::vector<Value> moreFields;
+
+    Value& field(int slot) {
+        return slot < INLINE_FIELDS ? fields[slot] : moreFields[slot - INLINE_FIELDS];
+    }
+
+    const Value& field(int slot) const {
+        return slot < INLINE_FIELDS ? fields[slot] : moreFields[slot - INLINE_FIELDS];
+    }
+
+    Value getSlow(const Token& name, PropertyCache& cache);
+    void setSlow(const Token& name, const Value& value, PropertyCache& cache);
+    LoxCallable* methodSlow(const Token& name, MethodCache& cache) const;
+    void moveTo(const Shape* next);
 };
+
+inline Value LoxInstance::get(const Token& name, PropertyCache& cache) {
+    if (const Value* value = cached(cache))
+        return *value;
+
+    return getSlow(name, cache);
+}
+
+inline void LoxInstance::set(const Token& name, const Value& value, PropertyCache& cache) {
+    if (const PropertyCache::Entry* entry = cache.find(shape)) {
+        if (entry->next != shape) moveTo(entry->next);
+        field(entry->slot) = value;
+        return;
+    }
+
+    setSlow(name, value, cache);
+}
+
+inline LoxCallable* LoxInstance::method(const Token& name, MethodCache& cache) const {
+    if (LoxCallable* method = cachedMethod(cache))
+        return method;
+
+    return methodSlow(name, cache);
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "../Runtime/Heap.h"
+
 #include <string>
 
-class LoxObject {
+// Anything a Lox value can refer to; created with Heap::make
+class LoxObject : public GcObject {
 public:
     virtual std::string toString() const = 0;
     virtual ~LoxObject() = default;
@@ -1,27 +1,107 @@
 #include "Interpreter.h"
 
+#include "../Runtime/CallDepth.h"
 #include "../Runtime/Runtime.h"
+#include "../Runtime/ValueOps.h"
 #include "../Include/LoxClass.h"
+#include "../Include/LoxBoundMethod.h"
 #include "../Include/LoxCallable.h"
 #include "../Include/LoxFunction.h"
 #include "../Include/LoxInstance.h"
 
-#include <memory>
 #include <string>
 #include <variant>
 
 // ---------- Public API ----------
 void Interpreter::interpret(
-    const std::vector<std::unique_ptr<Stmt>> &statements) {
+    std::span<Stmt* const> statements) {
+  globals.reserveSymbols();
+
   try {
     for (const auto &statement : statements) {
       execute(*statement);
     }
   } catch (RuntimeError error) {
+    resetStack();
     Runtime::runtimeError(error);
   }
 }
 
+Value Interpreter::call(
+    LoxFunction& function,
+    std::span<const Value> arguments,
+    LoxInstance* receiver)
+{
+    const Stmt::Function& declaration = *function.declaration;
+
+    std::size_t previousFrame = frameBase;
+    std::size_t previousCells = cellBase;
+    LoxFunction* previous = current;
+
+    // Arguments evaluated by a call expression are already the top of
+    // the stack and become the bottom of the frame. Only those from
+    // outside the stack have to be copied there
+    std::size_t count = arguments.size();
+    if (count > 0 && arguments.data() + count != stack.data() + stack.size())
+        stack.insert(stack.end(), arguments.begin(), arguments.end());
+
+    frameBase = stack.size() - count;
+    cellBase = cells.size();
+    current = &function;
+
+    cells.resize(cellBase + declaration.cellCount);
+
+    // Parameters that stay locals take the first slots in order, so an
+    // argument only moves down past those that went into cells
+    std::size_t locals = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        const Binding& binding = declaration.paramBindings[i];
+        const Value& argument = stack[frameBase + i];
+
+        if (binding.kind == Binding::Kind::CELL) {
+            cell(binding) = Heap::make<Cell>(argument);
+            continue;
+        }
+
+        if (locals != i) stack[frameBase + locals] = argument;
+        locals++;
+    }
+
+    for (std::size_t i = locals; i < count; i++)
+        stack[frameBase + i] = std::monostate{};
+
+    stack.resize(frameBase + declaration.slotCount);
+
+    if (receiver != nullptr)
+        define(declaration.thisBinding, declaration.name, receiver);
+
+    // A RuntimeError unwinds straight to interpret(), which resets the
+    // stack, so only normal completion has to pop the frame (and with
+    // it the arguments)
+    for (const auto& stmt : declaration.body) {
+        if (execute(*stmt) != Completion::NORMAL) break;
+    }
+
+    Value result = std::monostate{};
+
+    if (completion == Completion::RETURN) {
+        result = std::move(returnValue);
+        returnValue = std::monostate{};
+        completion = Completion::NORMAL;
+    }
+
+    if (declaration.initializer && receiver != nullptr)
+        result = receiver;
+
+    stack.resize(frameBase);
+    cells.resize(cellBase);
+    frameBase = previousFrame;
+    cellBase = previousCells;
+    current = previous;
+
+    return result;
+}
+
 // ---------- Override Visitor Function ----------
 Value Interpreter::visitLiteralExpr(const Expr::Literal &expr) { 
     return expr.value;
@@ -47,16 +127,17 @@ Value Interpreter::visitLogicalExpr(const Expr::Logical &expr) {
 Value Interpreter::visitSetExpr(const Expr::Set& expr) {
     Value receiver = evaluate(*expr.receiver);
 
-    if (!std::holds_alternative<std::shared_ptr<LoxInstance>>(receiver)) {
+    if (!receiver.isInstance()) {
         throw RuntimeError(expr.name,
                            "Only instances have fields.");
     }
 
-    auto instance = std::get<std::shared_ptr<LoxInstance>>(receiver);
+    LoxInstance* instance = receiver.asInstance();
 
+    Heap::Root root(receiver);
     Value value = evaluate(*expr.value);
 
-    instance->set(expr.name, value);
+    instance->set(expr.name, value, expr.cache);
 
     return value;
 }
@@ -67,7 +148,7 @@ Value Interpreter::visitUnaryExpr(const Expr::Unary &expr) {
   switch (expr.operator_.type) {
   case MINUS: {
     checkNumberOperand(expr.operator_, right);
-    double value = std::get<double>(right);
+    double value = right.asNumber();
     return -value;
   }
 
@@ -87,38 +168,41 @@ Value Interpreter::visitGroupingExpr(const Expr::Grouping &expr) {
 
 Value Interpreter::visitBinaryExpr(const Expr::Binary &expr) {
   Value left = evaluate(*expr.left);
+
+  // Only this frame holds `left` while the right operand runs
+  Heap::Root root(left);
   Value right = evaluate(*expr.right);
 
   switch (expr.operator_.type) {
   // Comparison Operator
   case GREATER:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) > std::get<double>(right);
+    return left.asNumber() > right.asNumber();
 
   case GREATER_EQUAL:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) >= std::get<double>(right);
+    return left.asNumber() >= right.asNumber();
 
   case LESS:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) < std::get<double>(right);
+    return left.asNumber() < right.asNumber();
 
   case LESS_EQUAL:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) <= std::get<double>(right);
+    return left.asNumber() <= right.asNumber();
 
   // Binary Operator
   case MINUS:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) - std::get<double>(right);
+    return left.asNumber() - right.asNumber();
 
   case PLUS: {
-    if (std::get_if<double>(&left) && std::get_if<double>(&right)) {
-      return std::get<double>(left) + std::get<double>(right);
+    if (left.isNumber() && right.isNumber()) {
+      return left.asNumber() + right.asNumber();
     }
 
-    if (std::get_if<std::string>(&left) && std::get_if<std::string>(&right)) {
-      return std::get<std::string>(left) + std::get<std::string>(right);
+    if (left.isString() && right.isString()) {
+      return LoxString::concat(left.asString(), right.asString());
     }
 
     throw RuntimeError(expr.operator_,
@@ -127,11 +211,11 @@ Value Interpreter::visitBinaryExpr(const Expr::Binary &expr) {
 
   case SLASH:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) / std::get<double>(right);
+    return left.asNumber() / right.asNumber();
 
   case STAR:
     checkNumberOperands(expr.operator_, left, right);
-    return std::get<double>(left) * std::get<double>(right);
+    return left.asNumber() * right.asNumber();
 
   // Equality Operator
   case BANG_EQUAL:
@@ -152,31 +236,97 @@ Value Interpreter::lookUpVariable(
     const Token& name, 
     const Expr::Variable& expr)
 {
-    auto it = locals.find(&expr);
-    
-    if (it != locals.end()) {
-        int distance = it->second;
-        return environment->getAt(distance, name.lexeme);
+    if (expr.binding.kind == Binding::Kind::GLOBAL) {
+        return globals.get(name);
     }
-    else {
-        return globals->get(name);
+
+    return variable(expr.binding);
+}
+
+Value& Interpreter::variable(const Binding& binding) {
+    switch (binding.kind) {
+    case Binding::Kind::LOCAL:
+        return stack[frameBase + binding.index];
+    case Binding::Kind::UPVALUE:
+        return current->captured[binding.index];
+    default:
+        return cell(binding)->value;
     }
 }
 
+Cell*& Interpreter::cell(const Binding& binding) {
+    if (binding.kind == Binding::Kind::CELL)
+        return cells[cellBase + binding.index];
+
+    return current->capturedCells[binding.index];
+}
+
+void Interpreter::define(
+    const Binding& binding,
+    const Token& name,
+    const Value& value)
+{
+    switch (binding.kind) {
+    case Binding::Kind::GLOBAL:
+        globals.define(name.symbol, value);
+        break;
+    case Binding::Kind::CELL:
+        cell(binding) = Heap::make<Cell>(value);
+        break;
+    default:
+        variable(binding) = value;
+        break;
+    }
+}
+
+void Interpreter::capture(LoxFunction& function) {
+    for (const Binding& capture : function.declaration->captures) {
+        if (capture.kind == Binding::Kind::CELL ||
+            capture.kind == Binding::Kind::UPVALUE_CELL)
+            function.capturedCells.push_back(cell(capture));
+        else
+            function.captured.push_back(variable(capture));
+    }
+}
+
+void Interpreter::markRoots() {
+    for (const GlobalEnvironment::Global& global : globals.values)
+        Heap::mark(global.value);
+
+    for (const Value& value : stack)
+        Heap::mark(value);
+
+    for (const Cell* cell : cells)
+        Heap::mark(cell);
+
+    Heap::mark(current);
+    Heap::mark(returnValue);
+}
+
+void Interpreter::resetStack() {
+    stack.clear();
+    cells.clear();
+    frameBase = 0;
+    cellBase = 0;
+    current = nullptr;
+    completion = Completion::NORMAL;
+    returnValue = std::monostate{};
+}
+
 Value Interpreter::visitVarStmt(const Stmt::Var& stmt) {
     Value value = std::monostate{};
 
     if (stmt.initializer) {
-        value = evaluate(*stmt.initializer.get());
+        value = evaluate(*stmt.initializer);
     }
 
-    environment->define(stmt.name.lexeme, value);
+    define(stmt.binding, stmt.name, value);
     return std::monostate{};
 }
 
 Value Interpreter::visitWhileStmt(const Stmt::While& stmt) {
     while (isTruthy(evaluate(*stmt.condition))) {
-        execute(*stmt.body);
+        if (execute(*stmt.body) != Completion::NORMAL) break;
     }
 
     return std::monostate{};
@@ -188,85 +338,25 @@ Value Interpreter::evaluate(const Expr& expr) {
     return expr.accept(*this);
 }
 
-void Interpreter::execute(const Stmt& stmt) { 
+Interpreter::Completion Interpreter::execute(const Stmt& stmt) { 
     stmt.accept(*this); 
-}
-
-void Interpreter::resolve(const Expr& expr, int depth) {
-    locals[&expr] = depth;
-}
-
-void Interpreter::executeBlock(
-    const std::vector<std::unique_ptr<Stmt>>& statements,
-    std::shared_ptr<Environment> newEnv)
-{
-    auto previous = environment;
-
-    try {
-        environment = newEnv;
-
-        for (const auto& stmt : statements) {
-            execute(*stmt);
-        }
-    }
-    catch (...) {
-        environment = previous;
-        throw;
-    }
-
-    environment = previous;
+    return completion;
 }
 
 bool Interpreter::isTruthy(const Value &value) {
-  if (std::holds_alternative<std::monostate>(value))
-    return false;
-
-  if (auto b = std::get_if<bool>(&value))
-    return *b;
-
-  return true;
+  return ValueOps::isTruthy(value);
 }
 
 bool Interpreter::isEqual(const Value &a, const Value &b) {
-  // std::variant handles type checking for yuh.
-  return a == b;
+  return ValueOps::isEqual(a, b);
 }
 
 std::string Interpreter::stringify(const Value &value) {
-  if (std::holds_alternative<std::monostate>(value))
-    return "nil";
-
-  if (auto d = std::get_if<double>(&value)) {
-    std::string text = std::to_string(*d);
-
-    if (text.size() >= 2 && text.substr(text.size() - 2) == ".0") {
-      text = text.substr(0, text.size() - 2);
-    }
-
-    return text;
-  }
-
-  if (auto b = std::get_if<bool>(&value)) {
-    return *b ? "true" : "false";
-  }
-
-  if (auto b = std::get_if<std::string>(&value)) {
-    return *b;
-  }
-
-    if (auto callable = std::get_if<std::shared_ptr<LoxCallable>>(&value)) {
-        return (*callable)->toString();
-    }
-
-    if (auto instance = std::get_if<std::shared_ptr<LoxInstance>>(&value)) {
-        return (*instance)->toString();
-    }
-
-  return "nil";
+  return ValueOps::stringify(value);
 }
 
 void Interpreter::checkNumberOperand(Token operator_, Value operand) {
-  if (auto d = std::get_if<double>(&operand))
+  if (operand.isNumber())
     return;
 
   throw RuntimeError(operator_, "Operand must be a number.");
@@ -274,7 +364,7 @@ void Interpreter::checkNumberOperand(Token operator_, Value operand) {
 
 void Interpreter::checkNumberOperands(Token operator_, Value left,
                                       Value right) {
-  if (std::get_if<double>(&left) && std::get_if<double>(&right)) {
+  if (left.isNumber() && right.isNumber()) {
     return;
   }
 
@@ -290,11 +380,19 @@ Value Interpreter::visitExpressionStmt(const Stmt::Expression &stmt) {
 
 Value Interpreter::visitFunctionStmt(const Stmt::Function& stmt) {
     // Wrap the function declaration in a LoxFunction
-    std::shared_ptr<LoxCallable> function =
-        std::make_shared<LoxFunction>(&stmt, environment);
+    auto function = Heap::make<LoxFunction>(&stmt);
+
+    // A function that refers to itself captures its own cell, so the
+    // cell has to exist first. Holding the function also keeps it alive
+    // while the cell is allocated
+    bool boxed = stmt.binding.kind == Binding::Kind::CELL;
+    if (boxed)
+        define(stmt.binding, stmt.name, function);
 
-    // Store it in the environment as a Value
-    environment->define(stmt.name.lexeme, Value(function));
+    capture(*function);
+
+    if (!boxed)
+        define(stmt.binding, stmt.name, function);
 
     return std::monostate{}; // functions don't return a value
 }
@@ -323,75 +421,208 @@ Value Interpreter::visitReturnStmt(const Stmt::Return& stmt) {
     if (stmt.value != nullptr)
         value = evaluate(*stmt.value);
 
-    // Returns value to the caller
-    throw Return(value);
+    // Unwinds to the caller through execute()
+    returnValue = std::move(value);
+    completion = Completion::RETURN;
+
+    return std::monostate{};
 }
 
 Value Interpreter::visitAssignExpr(const Expr::Assign& expr) {
     Value value = evaluate(*expr.value);
 
-    auto it = locals.find(&expr);
-
-    if (it != locals.end()) {
-        int distance = it->second;
-        environment->assignAt(distance, expr.name, value);
+    if (expr.binding.kind == Binding::Kind::GLOBAL) {
+        globals.assign(expr.name, value);
     } else {
-        globals->assign(expr.name, value);
+        variable(expr.binding) = value;
     }
 
     return value;
 }
 
 Value Interpreter::visitCallExpr(const Expr::Call& expr) {
-    Value callee = evaluate(*expr.callee);
+    if (expr.property != nullptr)
+        return invoke(expr, *expr.property);
 
-    std::vector<Value> arguments;
-    for (const auto& argument: expr.arguments){
-        arguments.push_back(evaluate(*argument));
+    if (expr.superMethod != nullptr) {
+        const Expr::Super& super = *expr.superMethod;
+        LoxCallable* method = superMethod(super);
+        return invokeMethod(expr, *method, variable(super.thisBinding).asInstance());
+    }
+
+    return callValue(expr, evaluate(*expr.callee));
+}
+
+Value Interpreter::invoke(const Expr::Call& expr, const Expr::Get& property) {
+    Value receiver = evaluate(*property.receiver);
+
+    if (!receiver.isInstance()) {
+        throw RuntimeError(property.name,
+                           "Only instances have properties.");
     }
 
-    if (!(std::holds_alternative<std::shared_ptr<LoxCallable>>(callee))) {
+    LoxInstance* instance = receiver.asInstance();
+    LoxCallable* method = instance->method(property.name, expr.cache);
+
+    // A field holding something callable, or no such property
+    if (method == nullptr)
+        return callValue(expr, instance->get(property.name, property.cache));
+
+    Heap::Root receiverRoot(receiver);
+    return invokeMethod(expr, *method, instance);
+}
+
+Value Interpreter::invokeMethod(
+    const Expr::Call& expr,
+    LoxCallable& method,
+    LoxInstance* receiver)
+{
+    std::size_t start = stack.size();
+    std::span<const Value> arguments = pushArguments(expr);
+
+    checkArity(expr.paren, method, static_cast<int>(arguments.size()));
+
+    CallDepth guard(callDepth, expr.paren);
+    Value result = method.callMethod(this, receiver, arguments);
+    stack.resize(start);
+    return result;
+}
+
+Value Interpreter::callValue(const Expr::Call& expr, const Value& callee) {
+    Heap::Root calleeRoot(callee);
+
+    std::size_t start = stack.size();
+    std::span<const Value> arguments = pushArguments(expr);
+
+    if (!(callee.isCallable())) {
         throw RuntimeError(expr.paren,
                            "Can only call function and classes.");
     }
 
-    std::shared_ptr<LoxCallable> function = std::get<std::shared_ptr<LoxCallable>>(callee);
+    LoxCallable* function = callee.asCallable();
+    checkArity(expr.paren, *function, static_cast<int>(arguments.size()));
 
-    if (arguments.size() != function->arity()) {
-        throw RuntimeError(expr.paren,
-                           "Expected " + std::to_string(function->arity()) +
-                           " arguments but got " + 
-                           std::to_string(arguments.size()) + ".");
+    CallDepth guard(callDepth, expr.paren);
+    Value result = function->call(this, arguments);
+    stack.resize(start);
+    return result;
+}
+
+std::span<const Value> Interpreter::pushArguments(const Expr::Call& expr) {
+    std::size_t start = stack.size();
+
+    for (const auto& argument: expr.arguments){
+        stack.push_back(evaluate(*argument));
     }
 
-    return function->call(this, arguments);
+    return {stack.data() + start, expr.arguments.size()};
+}
+
+void Interpreter::checkArity(
+    const Token& paren,
+    const LoxCallable& function,
+    int count)
+{
+    if (count != function.arity()) {
+        throw RuntimeError(paren,
+                           "Expected " + std::to_string(function.arity()) +
+                           " arguments but got " + 
+                           std::to_string(count) + ".");
+    }
 }
 
 Value Interpreter::visitGetExpr(const Expr::Get& expr) {
     Value receiver = evaluate(*expr.receiver);
 
-    if (auto instance = 
-        std::get_if<std::shared_ptr<LoxInstance>>(&receiver)) {
-
-        return (*instance)->get(expr.name);
+    if (receiver.isInstance()) {
+        return receiver.asInstance()->get(expr.name, expr.cache);
     }
 
     throw RuntimeError(expr.name,
                        "Only instances have properties.");
 }
 
+Value Interpreter::visitThisExpr(const Expr::This& expr) {
+    return variable(expr.binding);
+}
+
+Value Interpreter::visitSuperExpr(const Expr::Super& expr) {
+    LoxCallable* method = superMethod(expr);
+    return Heap::make<LoxBoundMethod>(variable(expr.thisBinding).asInstance(), method);
+}
+
+LoxCallable* Interpreter::superMethod(const Expr::Super& expr) {
+    // Only a class is ever stored in `super`
+    auto superclass = static_cast<LoxClass*>(variable(expr.binding).asCallable());
+    LoxCallable* method = superclass->findMethod(expr.method.symbol, expr.cache);
+
+    if (method == nullptr) {
+        throw RuntimeError(expr.method,
+                           "Undefined property '" + std::string(expr.method.lexeme) + "'.");
+    }
+
+    return method;
+}
+
 Value Interpreter::visitBlockStmt(const Stmt::Block& stmt) {
-    std::shared_ptr<Environment> newEnv = std::make_shared<Environment>(environment);
-    executeBlock(stmt.statements, newEnv);
+    // A call's frame is sized up front; top-level blocks grow the
+    // script's frame as they are entered
+    std::size_t slotEnd = frameBase + stmt.firstSlot + stmt.slotCount;
+    std::size_t cellEnd = cellBase + stmt.firstCell + stmt.cellCount;
+
+    if (stack.size() < slotEnd) stack.resize(slotEnd);
+    if (cells.size() < cellEnd) cells.resize(cellEnd);
+
+    for (const auto& statement : stmt.statements) {
+        if (execute(*statement) != Completion::NORMAL) break;
+    }
+
+    // Release the block's variables rather than leaving them to be
+    // overwritten by whatever reuses the slots
+    for (std::size_t i = slotEnd - stmt.slotCount; i < slotEnd; i++)
+        stack[i] = std::monostate{};
+    for (std::size_t i = cellEnd - stmt.cellCount; i < cellEnd; i++)
+        cells[i] = nullptr;
+
     return std::monostate{};
 }
 
 Value Interpreter::visitClassStmt(const Stmt::Class& stmt) {
-    environment->define(stmt.name.lexeme, std::monostate{});
+    auto klass = Heap::make<LoxClass>(std::string(stmt.name.lexeme));
+    Heap::Root root(klass);
+
+    // Named before the methods are made, so those that refer to the
+    // class capture it rather than an empty variable
+    define(stmt.binding, stmt.name, klass);
 
-    auto klass = std::make_shared<LoxClass>(stmt.name.lexeme);
+    if (stmt.superclass != nullptr) {
+        Value superclass = evaluate(*stmt.superclass);
+        auto parent = superclass.isCallable() ? dynamic_cast<LoxClass*>(superclass.asCallable())
+                                              : nullptr;
+
+        if (parent == nullptr) {
+            throw RuntimeError(stmt.superclass->name,
+                               "Superclass must be a class.");
+        }
+
+        klass->inherit(*parent);
+
+        // Top-level classes grow the script's frame for `super`, as
+        // top-level blocks do for their variables
+        std::size_t slot = frameBase + stmt.superBinding.index;
+        if (stack.size() <= slot) stack.resize(slot + 1);
+        define(stmt.superBinding, stmt.name, superclass);
+    }
+
+    for (const Stmt::Function* declaration : stmt.methods) {
+        auto method = Heap::make<LoxFunction>(declaration);
+        capture(*method);
+        klass->addMethod(declaration->name.symbol, method);
+    }
 
-    environment->assign(stmt.name, klass);
+    // The methods hold their own copies of `super`
+    if (stmt.superclass != nullptr)
+        variable(stmt.superBinding) = std::monostate{};
 
     return std::monostate{};
 }
@@ -3,31 +3,37 @@
 #include "RuntimeError.h"
 #include "../Runtime/Expr.h"
 #include "../Runtime/Stmt.h"
+#include "../Runtime/Heap.h"
 #include "../Runtime/Value.h"
-#include "../Runtime/Return.h"
 #include "../Semantic/Environment.h"
+#include "../Runtime/SymbolTable.h"
 #include "../Include/ClockCallable.h"
 
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <variant>
 #include <vector> 
 
+class LoxFunction;
+class LoxInstance;
+
 class Interpreter : public Expr::Visitor, Stmt::Visitor {
 public:
-    std::shared_ptr<Environment> globals;
-    std::shared_ptr<Environment> environment;
-    std::unordered_map<const Expr*, int> locals;
+    GlobalEnvironment globals;
+
+    // How a statement finished; a RETURN leaves its value in
+    // `returnValue` and unwinds to the enclosing call. Anything that
+    // stops a loop early (break, continue) belongs here too
+    enum class Completion { NORMAL, RETURN };
 
     Interpreter() 
-        : globals(std::make_shared<Environment>()),
-          environment(globals) 
     {
-        globals->define(
-            "clock",
-            Value(std::make_shared<ClockCallable>())
+        globals.define(
+            SymbolTable::intern("clock"),
+            Value(Heap::make<ClockCallable>())
         );
     }
 
@@ -40,29 +46,67 @@ public:
     Value visitUnaryExpr(const Expr::Unary& expr) override;
 
     // Public API
-    void interpret(const std::vector<std::unique_ptr<Stmt>>& statements);
-
-    void executeBlock(
-        const std::vector<std::unique_ptr<Stmt>>& statements,
-        std::shared_ptr<Environment> newEnv);
+    void interpret(std::span<Stmt* const> statements);
 
-    void resolve(const Expr& expr, int depth);
+    // Run `function`'s body in a fresh frame on the value stack, with
+    // `receiver` as `this` when it is a method. The frame starts at the
+    // arguments when they are the top of the stack
+    Value call(LoxFunction& function,
+               std::span<const Value> arguments,
+               LoxInstance* receiver = nullptr);
 
 private:
+    // Locals of every running call, one contiguous frame each, with a
+    // parallel stack for the cells. Top-level blocks use the frame at 0
+    std::vector<Value> stack;
+    std::vector<Cell*> cells;
+    std::size_t frameBase = 0;
+    std::size_t cellBase = 0;
+    // Function whose body is running, for its captures; null at top level
+    LoxFunction* current = nullptr;
+    // Calls in progress, bounded by CallDepth::MAX
+    int callDepth = 0;
+
+    Completion completion = Completion::NORMAL;
+    Value returnValue;
+
     Value evaluate(const Expr& expr); 
-    void execute(const Stmt& stmt);
+    Completion execute(const Stmt& stmt);
     bool isTruthy(const Value& value);
     bool isEqual(const Value& a, const Value& b);
     std::string stringify(const Value& value);
     void checkNumberOperand(Token operator_, Value operand);
     void checkNumberOperands(Token operator_, Value left, Value right);
     Value lookUpVariable(const Token& name, const Expr::Variable& expr);
+    // Storage for a non-global binding
+    Value& variable(const Binding& binding);
+    Cell*& cell(const Binding& binding);
+    // Initialize a declaration; a CELL gets a fresh cell each time
+    void define(const Binding& binding, const Token& name, const Value& value);
+    // Copy what `function`'s body uses out of the running frame
+    void capture(LoxFunction& function);
+    // `obj.name(...)`: a method runs on obj without being bound first
+    Value invoke(const Expr::Call& expr, const Expr::Get& property);
+    // Evaluate the arguments and run `method` on `receiver`
+    Value invokeMethod(const Expr::Call& expr, LoxCallable& method, LoxInstance* receiver);
+    // The superclass's method `super.name` refers to
+    LoxCallable* superMethod(const Expr::Super& expr);
+    // Evaluate the arguments and call `callee`
+    Value callValue(const Expr::Call& expr, const Value& callee);
+    // Evaluate the arguments onto the top of the stack, where the
+    // callee's frame picks them up; the caller pops whatever is left
+    std::span<const Value> pushArguments(const Expr::Call& expr);
+    void checkArity(const Token& paren, const LoxCallable& function, int count);
+    void resetStack();
+    void markRoots();
 
     // Override
     Value visitVarExpr(const Expr::Variable& expr) override;
     Value visitAssignExpr(const Expr::Assign& expr) override;
     Value visitCallExpr(const Expr::Call& expr) override;
     Value visitGetExpr(const Expr::Get& expr) override;
+    Value visitThisExpr(const Expr::This& expr) override;
+    Value visitSuperExpr(const Expr::Super& expr) override;
 
     Value visitExpressionStmt(const Stmt::Expression& stmt) override;
     Value visitFunctionStmt(const Stmt::Function& stmt) override;
@@ -73,4 +117,6 @@ private:
     Value visitBlockStmt(const Stmt::Block& stmt) override;
     Value visitClassStmt(const Stmt::Class& stmt) override;
     Value visitIfStmt(const Stmt::If& stmt) override;
+
+    Heap::Roots roots{[this] { markRoots(); }};
 };
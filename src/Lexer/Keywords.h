@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../Token/TokenType.h"
+
+#include <cstddef>
+#include <string_view>
+
+// Keyword recognition as a hand-rolled trie: switch on the first
+// character (and the second where several keywords share it), then
+// compare the remaining tail. No allocation, no hashing, and at most
+// one memcmp of a handful of bytes per identifier.
+class Keywords {
+public:
+    static constexpr TokenType classify(std::string_view text) {
+        if (text.size() < 2 || text.size() > 6) return TokenType::IDENTIFIER;
+
+        switch (text[0]) {
+            case 'a': return checkRest(text, 1, "nd", TokenType::AND);
+            case 'c': return checkRest(text, 1, "lass", TokenType::CLASS);
+            case 'e': return checkRest(text, 1, "lse", TokenType::ELSE);
+            case 'f':
+                switch (text[1]) {
+                    case 'a': return checkRest(text, 2, "lse", TokenType::FALSE);
+                    case 'o': return checkRest(text, 2, "r", TokenType::FOR);
+                    case 'u': return checkRest(text, 2, "n", TokenType::FUN);
+                }
+                break;
+            case 'i': return checkRest(text, 1, "f", TokenType::IF);
+            case 'n': return checkRest(text, 1, "il", TokenType::NIL);
+            case 'o': return checkRest(text, 1, "r", TokenType::OR);
+            case 'p': return checkRest(text, 1, "rint", TokenType::PRINT);
+            case 'r': return checkRest(text, 1, "eturn", TokenType::RETURN);
+            case 's': return checkRest(text, 1, "uper", TokenType::SUPER);
+            case 't':
+                switch (text[1]) {
+                    case 'h': return checkRest(text, 2, "is", TokenType::THIS);
+                    case 'r': return checkRest(text, 2, "ue", TokenType::TRUE);
+                }
+                break;
+            case 'v': return checkRest(text, 1, "ar", TokenType::VAR);
+            case 'w': return checkRest(text, 1, "hile", TokenType::WHILE);
+        }
+
+        return TokenType::IDENTIFIER;
+    }
+
+private:
+    // Matches when text is exactly text[0, start) + rest
+    static constexpr TokenType checkRest(std::string_view text,
+                                         std::size_t start,
+                                         std::string_view rest,
+                                         TokenType type) {
+        if (text.size() == start + rest.size() && text.substr(start) == rest)
+            return type;
+
+        return TokenType::IDENTIFIER;
+    }
+};
+
+// The whole table is checked at compile time
+static_assert(Keywords::classify("and") == TokenType::AND);
+static_assert(Keywords::classify("class") == TokenType::CLASS);
+static_assert(Keywords::classify("else") == TokenType::ELSE);
+static_assert(Keywords::classify("false") == TokenType::FALSE);
+static_assert(Keywords::classify("for") == TokenType::FOR);
+static_assert(Keywords::classify("fun") == TokenType::FUN);
+static_assert(Keywords::classify("if") == TokenType::IF);
+static_assert(Keywords::classify("nil") == TokenType::NIL);
+static_assert(Keywords::classify("or") == TokenType::OR);
+static_assert(Keywords::classify("print") == TokenType::PRINT);
+static_assert(Keywords::classify("return") == TokenType::RETURN);
+static_assert(Keywords::classify("super") == TokenType::SUPER);
+static_assert(Keywords::classify("this") == TokenType::THIS);
+static_assert(Keywords::classify("true") == TokenType::TRUE);
+static_assert(Keywords::classify("var") == TokenType::VAR);
+static_assert(Keywords::classify("while") == TokenType::WHILE);
+static_assert(Keywords::classify("an") == TokenType::IDENTIFIER);
+static_assert(Keywords::classify("andy") == TokenType::IDENTIFIER);
+static_assert(Keywords::classify("f") == TokenType::IDENTIFIER);
+static_assert(Keywords::classify("fn") == TokenType::IDENTIFIER);
+static_assert(Keywords::classify("thistle") == TokenType::IDENTIFIER);
+static_assert(Keywords::classify("_if") == TokenType::IDENTIFIER);
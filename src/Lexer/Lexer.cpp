@@ -1,36 +1,40 @@
 #include "Lexer.h"
+#include "Keywords.h"
+#include "SimdScan.h"
+#include "../Runtime/SymbolTable.h"
 
-// NOTE: It fails to handle string literals as of now
-const std::unordered_map<std::string, TokenType> Lexer::keywords = {
-    {"and",    TokenType::AND},
-    {"class",  TokenType::CLASS},
-    {"else",   TokenType::ELSE},
-    {"false",  TokenType::FALSE},
-    {"for",    TokenType::FOR},
-    {"fun",    TokenType::FUN},
-    {"if",     TokenType::IF},
-    {"nil",    TokenType::NIL},
-    {"or",     TokenType::OR},
-    {"print",  TokenType::PRINT},
-    {"return", TokenType::RETURN},
-    {"super",  TokenType::SUPER},
-    {"this",   TokenType::THIS},
-    {"true",   TokenType::TRUE},
-    {"var",    TokenType::VAR},
-    {"while",  TokenType::WHILE}
-};
+#include <charconv>
+
+Lexer::Lexer(std::string_view source): source(source){
+    // Guess one distinct identifier per 256 bytes of source; the table
+    // still grows past that, and a bigger guess only spreads the probes
+    SymbolTable::reserve(source.size() / 256);
+}
 
 // Array of Tokens
 std::vector<Token> Lexer::scanTokens(){
+    std::vector<Token> tokens;
+
     // Keep scanning until EOF
+    do {
+        tokens.push_back(nextToken());
+    } while (tokens.back().type != TokenType::END_OF_FILE);
+
+    return tokens;
+}
+
+Token Lexer::nextToken(){
+    // Whitespace and comments produce nothing, keep going
     while(!isAtEnd()){
         // Point the scanner to current lexeme beginning
         start=current;
+        produced=false;
         scanToken();
+
+        if(produced) return scanned;
     }
 
-    tokens.push_back(Token(TokenType::END_OF_FILE, "", Value{}, line));
-    return tokens;
+    return Token(TokenType::END_OF_FILE, "", line);
 }
 
 void Lexer::scanToken(){
@@ -65,7 +69,8 @@ void Lexer::scanToken(){
                   break;
         case '/':
                   if(match('/')){ // check if double-slash: comment
-                      while(peek() != '\n' && !isAtEnd()) advance();
+                      // Stop at the newline; the whitespace case counts it
+                      current = SimdScan::findLineEnd(source.data(), current, source.size());
                   }
                   else{ // divisor
                       addToken(TokenType::SLASH);
@@ -73,13 +78,14 @@ void Lexer::scanToken(){
                   break;
 
         // special character 
+        case '\n':
+                  line++;
+                  [[fallthrough]];
         case ' ':
         case '\r':
         case '\t':
-                  // Ignore whitespace
-                  break;
-        case '\n':
-                  line++;
+                  // Ignore whitespace, and the rest of the run with it
+                  current = SimdScan::skipWhitespace(source.data(), current, source.size(), line);
                   break;
 
         // literals
@@ -92,16 +98,16 @@ void Lexer::scanToken(){
 }
 
 void Lexer::identifier(){
-    while(isAlphaNumeric(peek())){
-        advance();
-    }
+    current = SimdScan::identifierEnd(source.data(), current, source.size());
 
-    std::string text = source.substr(start, current-start);
-
-    auto it = keywords.find(text);
-    TokenType type = (it != keywords.end()) ? it->second : TokenType::IDENTIFIER;
+    std::string_view text = source.substr(start, current-start);
+    TokenType type = Keywords::classify(text);
 
     addToken(type);
+    // `this` and `super` resolve like names, declared around methods
+    if (type == TokenType::IDENTIFIER || type == TokenType::THIS ||
+        type == TokenType::SUPER)
+        scanned.symbol = SymbolTable::intern(text);
 }
 
 bool Lexer::isAlpha(char c){
@@ -114,10 +120,6 @@ bool Lexer::isDigit(char c){
     return c >= '0' && c <= '9';
 }
 
-bool Lexer::isAlphaNumeric(char c){
-    return isAlpha(c) || isDigit(c);
-}
-
 void Lexer::number(){
     while(isDigit(peek())) advance();
 
@@ -127,24 +129,25 @@ void Lexer::number(){
         while(isDigit(peek())) advance();
     }
 
-    addToken(TokenType::NUMBER, std::stod(source.substr(start, current-start)));
+    // Parsed in place: no temporary string, and not locale-sensitive
+    double value = 0;
+    std::from_chars(source.data() + start, source.data() + current, value);
+    addToken(TokenType::NUMBER, value);
 }
 
 void Lexer::String(){
-    while(peek() != '"' && !isAtEnd()){
-        if(peek() == '\n') line++;
-        advance();
-    }
+    current = SimdScan::findQuote(source.data(), current, source.size(), line);
 
     if(isAtEnd()){
         Runtime::error(line, "Unterminated string.");
         return;
     }
 
+    // The closing ".
     advance();
 
-    std::string value = source.substr(start + 1, current - start - 2);
-    addToken(TokenType::STRING, value);
+    // The literal is the lexeme minus its quotes
+    addToken(TokenType::STRING);
 }
 
 // Function to check character for multiple character lexeme 
@@ -180,11 +183,12 @@ bool Lexer::isAtEnd(){
 
 // Function to add token with only its type 
 void Lexer::addToken(TokenType type){
-    addToken(type, "");
+    scanned = Token(type, source.substr(start, current-start), line);
+    produced = true;
 }
 
-// Overloaded Function to add token with type and literal
-void Lexer::addToken(TokenType type, Value literal){
-    std::string text=source.substr(start, current-start); 
-    tokens.push_back(Token(type, text, literal, line));
+// Overloaded Function to add a NUMBER token with its parsed value
+void Lexer::addToken(TokenType type, double number){
+    scanned = Token(type, source.substr(start, current-start), number, line);
+    produced = true;
 }
@@ -7,27 +7,30 @@
 #include <cstddef>
 #include <vector>
 #include <string>
-#include <any>
-#include <unordered_map>
+#include <string_view>
 
 class Lexer {
 public:
     // Constructor
-    Lexer(std::string source): source(source){};
+    // The source is scanned in place; it must outlive the tokens
+    Lexer(std::string_view source);
 
+    // Scan the whole source up front
     std::vector<Token> scanTokens();
+    // Scan just the next token; returns END_OF_FILE once exhausted
+    Token nextToken();
 
 private:
     std::size_t start = 0;
     std::size_t current = 0;
     int line = 1;
-    std::string source;
-    std::vector<Token> tokens;
-    static const std::unordered_map<std::string, TokenType> keywords;
+    std::string_view source;
+    // Set by addToken while scanning
+    Token scanned;
+    bool produced = false;
 
     void scanToken();
     bool isAlpha(char c);
-    bool isAlphaNumeric(char c);
     bool isDigit(char c);
     void identifier();
     void number();
@@ -38,5 +41,5 @@ private:
     char advance();
     bool isAtEnd();
     void addToken(TokenType type);
-    void addToken(TokenType type, Value literal);
+    void addToken(TokenType type, double number);
 };
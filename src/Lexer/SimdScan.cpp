@@ -0,0 +1,295 @@
+#include "SimdScan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPPLOX_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define CPPLOX_SIMD_X86 0
+#endif
+
+#include <cstdint>
+
+// ------------ Scalar ------------
+static bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') ||
+           (c == '_');
+}
+
+static std::size_t skipWhitespaceScalar(const char* src, std::size_t pos, std::size_t end, int& line) {
+    for (; pos < end; pos++) {
+        char c = src[pos];
+        if (c == '\n') line++;
+        else if (c != ' ' && c != '\t' && c != '\r') break;
+    }
+    return pos;
+}
+
+static std::size_t findLineEndScalar(const char* src, std::size_t pos, std::size_t end) {
+    while (pos < end && src[pos] != '\n') pos++;
+    return pos;
+}
+
+static std::size_t findQuoteScalar(const char* src, std::size_t pos, std::size_t end, int& line) {
+    for (; pos < end; pos++) {
+        char c = src[pos];
+        if (c == '"') break;
+        if (c == '\n') line++;
+    }
+    return pos;
+}
+
+static std::size_t identifierEndScalar(const char* src, std::size_t pos, std::size_t end) {
+    while (pos < end && isIdentifierChar(src[pos])) pos++;
+    return pos;
+}
+
+#if CPPLOX_SIMD_X86
+
+// Newlines among the lowest `count` bits of a byte mask
+static int newlinesBelow(std::uint32_t newlineMask, int count) {
+    if (count < 32) newlineMask &= (1u << count) - 1;
+    return __builtin_popcount(newlineMask);
+}
+
+// ------------ SSE2 (16 bytes per step) ------------
+static std::size_t skipWhitespaceSse2(const char* src, std::size_t pos, std::size_t end, int& line) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (pos + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        __m128i newlines = _mm_cmpeq_epi8(chunk, nl);
+        __m128i blank = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newlines));
+
+        std::uint32_t blankMask = _mm_movemask_epi8(blank);
+        std::uint32_t newlineMask = _mm_movemask_epi8(newlines);
+
+        if (blankMask != 0xFFFF) {
+            int stop = __builtin_ctz(~blankMask);
+            line += newlinesBelow(newlineMask, stop);
+            return pos + stop;
+        }
+
+        line += __builtin_popcount(newlineMask);
+        pos += 16;
+    }
+
+    return skipWhitespaceScalar(src, pos, end, line);
+}
+
+static std::size_t findLineEndSse2(const char* src, std::size_t pos, std::size_t end) {
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (pos + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        std::uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl));
+
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 16;
+    }
+
+    return findLineEndScalar(src, pos, end);
+}
+
+static std::size_t findQuoteSse2(const char* src, std::size_t pos, std::size_t end, int& line) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i nl = _mm_set1_epi8('\n');
+
+    while (pos + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        std::uint32_t quoteMask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote));
+        std::uint32_t newlineMask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, nl));
+
+        if (quoteMask != 0) {
+            int stop = __builtin_ctz(quoteMask);
+            line += newlinesBelow(newlineMask, stop);
+            return pos + stop;
+        }
+
+        line += __builtin_popcount(newlineMask);
+        pos += 16;
+    }
+
+    return findQuoteScalar(src, pos, end, line);
+}
+
+// Bytes in [lo, hi]; bytes >= 0x80 compare as negative and fall outside
+static __m128i inRangeSse2(__m128i chunk, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(lo - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), chunk));
+}
+
+static std::size_t identifierEndSse2(const char* src, std::size_t pos, std::size_t end) {
+    const __m128i lowerBit = _mm_set1_epi8(0x20);
+    const __m128i underscore = _mm_set1_epi8('_');
+
+    while (pos + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + pos));
+        // Folding 'A'-'Z' onto 'a'-'z' leaves no other byte in that range
+        __m128i letter = inRangeSse2(_mm_or_si128(chunk, lowerBit), 'a', 'z');
+        __m128i digit = inRangeSse2(chunk, '0', '9');
+        __m128i word = _mm_or_si128(_mm_or_si128(letter, digit),
+                                    _mm_cmpeq_epi8(chunk, underscore));
+
+        std::uint32_t mask = _mm_movemask_epi8(word);
+        if (mask != 0xFFFF) return pos + __builtin_ctz(~mask);
+        pos += 16;
+    }
+
+    return identifierEndScalar(src, pos, end);
+}
+
+// ------------ AVX2 (32 bytes per step) ------------
+#define CPPLOX_AVX2 __attribute__((target("avx2")))
+
+CPPLOX_AVX2
+static std::size_t skipWhitespaceAvx2(const char* src, std::size_t pos, std::size_t end, int& line) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (pos + 32 <= end) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        __m256i newlines = _mm256_cmpeq_epi8(chunk, nl);
+        __m256i blank = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, cr), newlines));
+
+        std::uint32_t blankMask = _mm256_movemask_epi8(blank);
+        std::uint32_t newlineMask = _mm256_movemask_epi8(newlines);
+
+        if (blankMask != 0xFFFFFFFFu) {
+            int stop = __builtin_ctz(~blankMask);
+            line += newlinesBelow(newlineMask, stop);
+            return pos + stop;
+        }
+
+        line += __builtin_popcount(newlineMask);
+        pos += 32;
+    }
+
+    return skipWhitespaceSse2(src, pos, end, line);
+}
+
+CPPLOX_AVX2
+static std::size_t findLineEndAvx2(const char* src, std::size_t pos, std::size_t end) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (pos + 32 <= end) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        std::uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl));
+
+        if (mask != 0) return pos + __builtin_ctz(mask);
+        pos += 32;
+    }
+
+    return findLineEndSse2(src, pos, end);
+}
+
+CPPLOX_AVX2
+static std::size_t findQuoteAvx2(const char* src, std::size_t pos, std::size_t end, int& line) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i nl = _mm256_set1_epi8('\n');
+
+    while (pos + 32 <= end) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        std::uint32_t quoteMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote));
+        std::uint32_t newlineMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, nl));
+
+        if (quoteMask != 0) {
+            int stop = __builtin_ctz(quoteMask);
+            line += newlinesBelow(newlineMask, stop);
+            return pos + stop;
+        }
+
+        line += __builtin_popcount(newlineMask);
+        pos += 32;
+    }
+
+    return findQuoteSse2(src, pos, end, line);
+}
+
+CPPLOX_AVX2
+static __m256i inRangeAvx2(__m256i chunk, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(chunk, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), chunk));
+}
+
+CPPLOX_AVX2
+static std::size_t identifierEndAvx2(const char* src, std::size_t pos, std::size_t end) {
+    const __m256i lowerBit = _mm256_set1_epi8(0x20);
+    const __m256i underscore = _mm256_set1_epi8('_');
+
+    while (pos + 32 <= end) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + pos));
+        __m256i letter = inRangeAvx2(_mm256_or_si256(chunk, lowerBit), 'a', 'z');
+        __m256i digit = inRangeAvx2(chunk, '0', '9');
+        __m256i word = _mm256_or_si256(_mm256_or_si256(letter, digit),
+                                       _mm256_cmpeq_epi8(chunk, underscore));
+
+        std::uint32_t mask = _mm256_movemask_epi8(word);
+        if (mask != 0xFFFFFFFFu) return pos + __builtin_ctz(~mask);
+        pos += 32;
+    }
+
+    return identifierEndSse2(src, pos, end);
+}
+
+#endif // CPPLOX_SIMD_X86
+
+// ------------ Dispatch ------------
+static SimdScan::Level supportedLevel() {
+#if CPPLOX_SIMD_X86
+    if (__builtin_cpu_supports("avx2")) return SimdScan::Level::AVX2;
+    return SimdScan::Level::SSE2;
+#else
+    return SimdScan::Level::SCALAR;
+#endif
+}
+
+SimdScan::Kernels SimdScan::select(Level wanted) {
+    Level supported = supportedLevel();
+    if (wanted > supported) wanted = supported;
+
+    switch (wanted) {
+#if CPPLOX_SIMD_X86
+        case Level::AVX2:
+            return {skipWhitespaceAvx2, findLineEndAvx2, findQuoteAvx2,
+                    identifierEndAvx2, Level::AVX2};
+        case Level::SSE2:
+            return {skipWhitespaceSse2, findLineEndSse2, findQuoteSse2,
+                    identifierEndSse2, Level::SSE2};
+#endif
+        default:
+            return {skipWhitespaceScalar, findLineEndScalar, findQuoteScalar,
+                    identifierEndScalar, Level::SCALAR};
+    }
+}
+
+SimdScan::Kernels& SimdScan::kernels() {
+    static Kernels selected = select(supportedLevel());
+    return selected;
+}
+
+SimdScan::Level SimdScan::level() {
+    return kernels().level;
+}
+
+void SimdScan::setLevel(Level level) {
+    kernels() = select(level);
+}
+
+const char* SimdScan::levelName(Level level) {
+    switch (level) {
+        case Level::AVX2: return "avx2";
+        case Level::SSE2: return "sse2";
+        default:          return "scalar";
+    }
+}
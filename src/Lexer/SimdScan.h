@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+
+// Bulk scanning kernels for the lexer's long runs: whitespace,
+// comment bodies, string bodies and identifiers. Each kernel takes
+// the source as [pos, end) and returns the index of the first byte
+// that ends the run (or end). Newlines crossed are added to `line`.
+//
+// The x86 kernels test 16 (SSE2) or 32 (AVX2) bytes per step and are
+// picked once at startup from what the CPU supports; everything else
+// uses the scalar loops. No kernel reads at or past `end`, so mapped
+// sources need no padding. Runs that end on their first byte (a single
+// space between tokens, a one-letter name) are answered inline without
+// going through the dispatch table.
+class SimdScan {
+public:
+    enum class Level { SCALAR, SSE2, AVX2 };
+
+    // Run of ' ', '\t', '\r', '\n'
+    static std::size_t skipWhitespace(const char* src, std::size_t pos, std::size_t end, int& line) {
+        if (pos >= end || !isBlank(src[pos])) return pos;
+        return kernels().skipWhitespace(src, pos, end, line);
+    }
+
+    // Next '\n' (the end of a // comment)
+    static std::size_t findLineEnd(const char* src, std::size_t pos, std::size_t end) {
+        return kernels().findLineEnd(src, pos, end);
+    }
+
+    // Next '"' (the end of a string body)
+    static std::size_t findQuote(const char* src, std::size_t pos, std::size_t end, int& line) {
+        return kernels().findQuote(src, pos, end, line);
+    }
+
+    // Run of [A-Za-z0-9_]
+    static std::size_t identifierEnd(const char* src, std::size_t pos, std::size_t end) {
+        if (pos >= end || !isWordChar(src[pos])) return pos;
+        return kernels().identifierEnd(src, pos, end);
+    }
+
+    static Level level();
+    // Downgrade (or restore) the kernels in use; requests above what
+    // the CPU supports are clamped. Meant for benchmarks and testing.
+    static void setLevel(Level level);
+    static const char* levelName(Level level);
+
+private:
+    static bool isBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    static bool isWordChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_';
+    }
+
+    struct Kernels {
+        std::size_t (*skipWhitespace)(const char*, std::size_t, std::size_t, int&);
+        std::size_t (*findLineEnd)(const char*, std::size_t, std::size_t);
+        std::size_t (*findQuote)(const char*, std::size_t, std::size_t, int&);
+        std::size_t (*identifierEnd)(const char*, std::size_t, std::size_t);
+        Level level;
+    };
+
+    static Kernels& kernels();
+    static Kernels select(Level wanted);
+};
@@ -1,28 +1,166 @@
 #include "Parser.h"
+#include "../Lexer/Lexer.h"
 #include <memory>
 #include <vector>
 
+// ------------ Pratt Parser ------------
+const std::array<Parser::ParseRule, END_OF_FILE + 1> Parser::rules = [] {
+    std::array<ParseRule, END_OF_FILE + 1> table{};
+
+    table[LEFT_PAREN]    = {&Parser::grouping,    &Parser::callInfix, Precedence::CALL};
+    table[DOT]           = {nullptr,              &Parser::dot,       Precedence::CALL};
+    table[MINUS]         = {&Parser::prefixUnary, &Parser::binary,    Precedence::TERM};
+    table[PLUS]          = {nullptr,              &Parser::binary,    Precedence::TERM};
+    table[SLASH]         = {nullptr,              &Parser::binary,    Precedence::FACTOR};
+    table[STAR]          = {nullptr,              &Parser::binary,    Precedence::FACTOR};
+    table[BANG]          = {&Parser::prefixUnary, nullptr,            Precedence::NONE};
+    table[BANG_EQUAL]    = {nullptr,              &Parser::binary,    Precedence::EQUALITY};
+    table[EQUAL]         = {nullptr,              &Parser::assign,    Precedence::ASSIGNMENT};
+    table[EQUAL_EQUAL]   = {nullptr,              &Parser::binary,    Precedence::EQUALITY};
+    table[GREATER]       = {nullptr,              &Parser::binary,    Precedence::COMPARISON};
+    table[GREATER_EQUAL] = {nullptr,              &Parser::binary,    Precedence::COMPARISON};
+    table[LESS]          = {nullptr,              &Parser::binary,    Precedence::COMPARISON};
+    table[LESS_EQUAL]    = {nullptr,              &Parser::binary,    Precedence::COMPARISON};
+    table[IDENTIFIER]    = {&Parser::variable,    nullptr,            Precedence::NONE};
+    table[THIS]          = {&Parser::thisExpr,    nullptr,            Precedence::NONE};
+    table[SUPER]         = {&Parser::superExpr,   nullptr,            Precedence::NONE};
+    table[STRING]        = {&Parser::literal,     nullptr,            Precedence::NONE};
+    table[NUMBER]        = {&Parser::literal,     nullptr,            Precedence::NONE};
+    table[AND]           = {nullptr,              &Parser::logical,   Precedence::AND};
+    table[OR]            = {nullptr,              &Parser::logical,   Precedence::OR};
+    table[FALSE]         = {&Parser::literal,     nullptr,            Precedence::NONE};
+    table[NIL]           = {&Parser::literal,     nullptr,            Precedence::NONE};
+    table[TRUE]          = {&Parser::literal,     nullptr,            Precedence::NONE};
+
+    return table;
+}();
+
+Expr* Parser::parsePrecedence(Precedence precedence) {
+    PrefixFn prefix = rules[peek().type].prefix;
+    if (prefix == nullptr) throw error(peek(), "Expect expression.");
+
+    advance();
+    Expr* expr = (this->*prefix)();
+
+    while (precedence <= rules[peek().type].precedence) {
+        InfixFn infix = rules[advance().type].infix;
+        expr = (this->*infix)(expr);
+    }
+
+    return expr;
+}
+
+Expr* Parser::literal() {
+    const Token& token = previous();
+
+    switch (token.type) {
+        case FALSE:  return arena.make<Expr::Literal>(constants.boolean(false));
+        case TRUE:   return arena.make<Expr::Literal>(constants.boolean(true));
+        case NIL:    return arena.make<Expr::Literal>(constants.nil());
+        case NUMBER: return arena.make<Expr::Literal>(constants.number(token.number));
+        default: {
+            // Strip the surrounding quotes
+            std::string_view lexeme = token.lexeme;
+            return arena.make<Expr::Literal>(
+                constants.string(lexeme.substr(1, lexeme.size() - 2)));
+        }
+    }
+}
+
+Expr* Parser::variable() {
+    return arena.make<Expr::Variable>(previous());
+}
+
+Expr* Parser::thisExpr() {
+    return arena.make<Expr::This>(previous());
+}
+
+Expr* Parser::superExpr() {
+    Token keyword = previous();
+    consume(DOT, "Expect '.' after 'super'.");
+    Token method = consume(IDENTIFIER, "Expect superclass method name.");
+    return arena.make<Expr::Super>(keyword, method);
+}
+
+Expr* Parser::grouping() {
+    Expr* expr = expression();
+    consume(RIGHT_PAREN, "Expect ')' after expression.");
+    return arena.make<Expr::Grouping>(expr);
+}
+
+Expr* Parser::prefixUnary() {
+    Token operator_ = previous();
+    Expr* right = parsePrecedence(Precedence::UNARY);
+    return arena.make<Expr::Unary>(operator_, right);
+}
+
+Expr* Parser::binary(Expr* left) {
+    // Left associative: the right operand must bind tighter
+    Token operator_ = previous();
+    auto next = static_cast<Precedence>(
+        static_cast<std::uint8_t>(rules[operator_.type].precedence) + 1);
+
+    Expr* right = parsePrecedence(next);
+    return arena.make<Expr::Binary>(left, operator_, right);
+}
+
+Expr* Parser::logical(Expr* left) {
+    Token operator_ = previous();
+    auto next = static_cast<Precedence>(
+        static_cast<std::uint8_t>(rules[operator_.type].precedence) + 1);
+
+    Expr* right = parsePrecedence(next);
+    return arena.make<Expr::Logical>(left, operator_, right);
+}
+
+Expr* Parser::assign(Expr* left) {
+    // Right associative, and only reached at assignment precedence
+    Token equals = previous();
+    Expr* value = parsePrecedence(Precedence::ASSIGNMENT);
+
+    if (auto var = dynamic_cast<Expr::Variable*>(left)) {
+        return arena.make<Expr::Assign>(var->name, value);
+    }
+    else if (auto get = dynamic_cast<Expr::Get*>(left)) {
+        return arena.make<Expr::Set>(get->receiver, get->name, value);
+    }
+
+    throw error(equals, "Invalid assignment target.");
+}
+
+Expr* Parser::callInfix(Expr* left) {
+    return finishCall(left);
+}
+
+Expr* Parser::dot(Expr* left) {
+    Token name = consume(IDENTIFIER, "Expect property name after '.'.");
+    return arena.make<Expr::Get>(left, name);
+}
+
 // ------------ Rules ------------
-std::unique_ptr<Expr> Parser::expression(){
+Expr* Parser::expression(){
+    if (grammar == Grammar::PRATT)
+        return parsePrecedence(Precedence::ASSIGNMENT);
+
     return assignment();
 }
 
-std::unique_ptr<Expr> Parser::assignment() {
-    std::unique_ptr<Expr> expr = logicOr();
+Expr* Parser::assignment() {
+    Expr* expr = logicOr();
 
     if (match({EQUAL})) {
         Token equals = previous();
-        std::unique_ptr<Expr> value = assignment();
+        Expr* value = assignment();
 
-        if (auto var = dynamic_cast<Expr::Variable*>(expr.get())) {
+        if (auto var = dynamic_cast<Expr::Variable*>(expr)) {
             Token name = var->name;
-            return std::make_unique<Expr::Assign>(name, std::move(value));
+            return arena.make<Expr::Assign>(name, value);
         }
-        else if (auto get = dynamic_cast<Expr::Get*>(expr.get())) {
-            return std::make_unique<Expr::Set>(
+        else if (auto get = dynamic_cast<Expr::Get*>(expr)) {
+            return arena.make<Expr::Set>(
                 std::move(get->receiver),
                 get->name,
-                std::move(value)
+                value
             );
         }
 
@@ -32,41 +170,41 @@ std::unique_ptr<Expr> Parser::assignment() {
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::logicOr() {
-    std::unique_ptr<Expr> expr = logicAnd();
+Expr* Parser::logicOr() {
+    Expr* expr = logicAnd();
 
     while (match({OR})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = logicAnd();
+        Expr* right = logicAnd();
 
-        expr = std::make_unique<Expr::Logical>(
-            std::move(expr),
-            std::move(operator_),
-            std::move(right)
+        expr = arena.make<Expr::Logical>(
+            expr,
+            operator_,
+            right
         );
     }
 
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::logicAnd() {
-    std::unique_ptr<Expr> expr = equality();
+Expr* Parser::logicAnd() {
+    Expr* expr = equality();
 
     while (match({AND})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = equality();
+        Expr* right = equality();
 
-        expr = std::make_unique<Expr::Logical>(
-            std::move(expr),
-            std::move(operator_),
-            std::move(right)
+        expr = arena.make<Expr::Logical>(
+            expr,
+            operator_,
+            right
         );
     }
 
     return expr;
 }
 
-std::unique_ptr<Stmt> Parser::declaration() {
+Stmt* Parser::declaration() {
     try {
         if (match({CLASS}))
             return classDeclaration();
@@ -85,95 +223,95 @@ std::unique_ptr<Stmt> Parser::declaration() {
     }
 }
 
-std::unique_ptr<Stmt> Parser::classDeclaration() {
+Stmt* Parser::classDeclaration() {
     Token name = consume(IDENTIFIER, "Expect class name.");
 
-    std::unique_ptr<Expr::Variable> superclass = nullptr;
+    Expr::Variable* superclass = nullptr;
     if (match({LESS})) {
         Token superName = consume(IDENTIFIER, "Expect superclass name.");
-        superclass = std::make_unique<Expr::Variable>(superName);
+        superclass = arena.make<Expr::Variable>(superName);
     }
 
     consume(LEFT_BRACE, "Expect '{' before class body.");
 
-    std::vector<std::unique_ptr<Stmt::Function>> methods;
+    std::vector<Stmt::Function*> methods;
     while (!check(RIGHT_BRACE) && !isAtEnd()) {
         methods.push_back(function("method"));
     }
 
     consume(RIGHT_BRACE, "Expect '}' after class body.");
 
-    return std::make_unique<Stmt::Class>(
-        std::move(name),
-        std::move(superclass),
-        std::move(methods)
+    return arena.make<Stmt::Class>(
+        name,
+        superclass,
+        arena.copy(methods)
     );
 }
 
-std::unique_ptr<Expr> Parser::equality(){
+Expr* Parser::equality(){
     // equality → comparison ( ( "!=" | "==" ) comparison )* ;
-    std::unique_ptr<Expr> expr = comparison();
+    Expr* expr = comparison();
 
     while (match({BANG_EQUAL, EQUAL_EQUAL})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = comparison();
-        expr = std::make_unique<Expr::Binary>(std::move(expr), operator_, std::move(right));
+        Expr* right = comparison();
+        expr = arena.make<Expr::Binary>(expr, operator_, right);
     }
 
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::comparison(){
+Expr* Parser::comparison(){
     // comparison → term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
-    std::unique_ptr<Expr> expr = term();
+    Expr* expr = term();
 
     while (match({GREATER, GREATER_EQUAL, LESS, LESS_EQUAL})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = term();
-        expr = std::make_unique<Expr::Binary>(std::move(expr), operator_, std::move(right));
+        Expr* right = term();
+        expr = arena.make<Expr::Binary>(expr, operator_, right);
     }
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::term(){
+Expr* Parser::term(){
     // term → factor ( ( "-" | "+" ) factor )* ;
-    std::unique_ptr<Expr> expr = factor();
+    Expr* expr = factor();
 
     while (match({MINUS, PLUS})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = factor();
-        expr = std::make_unique<Expr::Binary>(std::move(expr), operator_, std::move(right));
+        Expr* right = factor();
+        expr = arena.make<Expr::Binary>(expr, operator_, right);
     }
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::factor(){
+Expr* Parser::factor(){
     // factor → unary ( ( "/" | "*" ) unary )* ;
-    std::unique_ptr<Expr> expr = unary();
+    Expr* expr = unary();
 
     while (match({SLASH, STAR})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = unary();
-        expr = std::make_unique<Expr::Binary>(std::move(expr), operator_, std::move(right));
+        Expr* right = unary();
+        expr = arena.make<Expr::Binary>(expr, operator_, right);
     }
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::unary(){
+Expr* Parser::unary(){
     // unary → ( "!" | "-" ) unary | call ;
     while (match({BANG, MINUS})) {
         Token operator_ = previous();
-        std::unique_ptr<Expr> right = unary();
-        return std::make_unique<Expr::Unary>(operator_, std::move(right));
+        Expr* right = unary();
+        return arena.make<Expr::Unary>(operator_, right);
     }
 
     return call();
 }
 
-std::unique_ptr<Expr> Parser::call(){
+Expr* Parser::call(){
     // call → primary ( "(" arguments? ")" )* ;
     // arguments → expression ( "," expression )* ;
-    std::unique_ptr<Expr> expr = primary();
+    Expr* expr = primary();
     while (true) {
         if (match({LEFT_PAREN})) {
             expr = finishCall(expr);
@@ -181,7 +319,7 @@ std::unique_ptr<Expr> Parser::call(){
         else if (match({DOT})) {
             Token name = consume(IDENTIFIER,
                                  "Expect property name after '.'.");
-            expr = std::make_unique<Expr::Get>(std::move(expr), name);
+            expr = arena.make<Expr::Get>(expr, name);
         }
         else {
             break;
@@ -191,8 +329,8 @@ std::unique_ptr<Expr> Parser::call(){
     return expr;
 }
 
-std::unique_ptr<Expr> Parser::finishCall(std::unique_ptr<Expr>& callee){
-    std::vector<std::unique_ptr<Expr>> arguments;
+Expr* Parser::finishCall(Expr*& callee){
+    std::vector<Expr*> arguments;
     if (!check(RIGHT_PAREN)) {
         do {
             if (arguments.size() >= 255) {
@@ -205,41 +343,46 @@ std::unique_ptr<Expr> Parser::finishCall(std::unique_ptr<Expr>& callee){
     Token paren = consume(RIGHT_PAREN,
                           "Expect ')' after arguments.");
 
-    return std::make_unique<Expr::Call>(std::move(callee), 
-                                        paren, 
-                                        std::move(arguments));
+    return arena.make<Expr::Call>(callee, 
+                                  paren, 
+                                  arena.copy(arguments),
+                                  dynamic_cast<Expr::Get*>(callee),
+                                  dynamic_cast<Expr::Super*>(callee));
 }
 
-std::unique_ptr<Expr> Parser::primary(){
-    // primary → NUMBER | STRING | "true" | "false" | "nil" | "(" expression ")" | IDENTIFIER ;
-    if (match({FALSE})) return std::make_unique<Expr::Literal>(false);
-    if (match({TRUE})) return std::make_unique<Expr::Literal>(true);
-    if (match({NIL})) return std::make_unique<Expr::Literal>(std::monostate{});
+Expr* Parser::primary(){
+    // primary → NUMBER | STRING | "true" | "false" | "nil" | "this"
+    //         | "super" "." IDENTIFIER | "(" expression ")" | IDENTIFIER ;
+    if (match({FALSE, TRUE, NIL, NUMBER, STRING})) return literal();
 
-    if (match({NUMBER, STRING})) {
-        return std::make_unique<Expr::Literal>(previous().literal);
+    if (match({IDENTIFIER})) {
+        return arena.make<Expr::Variable>(previous());
     }
 
-    if (match({IDENTIFIER})) {
-        return std::make_unique<Expr::Variable>(previous());
+    if (match({THIS})) {
+        return arena.make<Expr::This>(previous());
+    }
+
+    if (match({SUPER})) {
+        return superExpr();
     }
 
     if(match({LEFT_PAREN})) {
-        std::unique_ptr<Expr> expr = expression();
+        Expr* expr = expression();
         consume(RIGHT_PAREN, "Expect ')' after expression.");
-        return std::make_unique<Expr::Grouping>(std::move(expr));
+        return arena.make<Expr::Grouping>(expr);
     }
 
     throw error(peek(), "Expect expression.");
 }
 
-std::vector<std::unique_ptr<Stmt>> Parser::parse() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+std::span<Stmt* const> Parser::parse() {
+    std::vector<Stmt*> statements;
     while (!isAtEnd()) {
         statements.push_back(declaration());
     }
 
-    return statements;
+    return arena.copy(statements);
 }
 
 // ----------- Nested Class -----------
@@ -277,7 +420,7 @@ void Parser::synchronize() {
 }
 
 // ------------ Private Helpers ------------
-std::unique_ptr<Stmt> Parser::statement() {
+Stmt* Parser::statement() {
     if (match({FOR}))
         return forStatement();
 
@@ -294,17 +437,16 @@ std::unique_ptr<Stmt> Parser::statement() {
         return whileStatement();
 
     if (match({LEFT_BRACE})){
-        std::vector<std::unique_ptr<Stmt>> statements = block();
-        return std::make_unique<Stmt::Block>(std::move(statements));
+        return arena.make<Stmt::Block>(block());
     }
 
     return expressionStatement();
 }
 
-std::unique_ptr<Stmt> Parser::forStatement() {
+Stmt* Parser::forStatement() {
     consume(LEFT_PAREN, "Expect '(' after 'for'.");
 
-    std::unique_ptr<Stmt> initializer;
+    Stmt* initializer;
 
     // Var initializer
     if (match({SEMICOLON})) {
@@ -318,52 +460,51 @@ std::unique_ptr<Stmt> Parser::forStatement() {
     }
 
     // Loop condition
-    std::unique_ptr<Expr> condition = nullptr;
+    Expr* condition = nullptr;
     if (!check(SEMICOLON)) {
         condition = expression();
     }
     consume(SEMICOLON, "Expect ';' after loop condition.");
     
     // Var increment
-    std::unique_ptr<Expr> increment = nullptr;
+    Expr* increment = nullptr;
     if (!check(RIGHT_PAREN)) {
         increment = expression();
     }
     consume(RIGHT_PAREN, "Expect ')' after for clauses.");
 
     // Syntactic Sugar: For -> While 
-    std::unique_ptr<Stmt> body = statement();
+    Stmt* body = statement();
 
     if (increment != nullptr) {
-        std::vector<std::unique_ptr<Stmt>> statements;
+        std::vector<Stmt*> statements;
 
-        statements.push_back(std::move(body));
+        statements.push_back(body);
         statements.push_back(
-            std::make_unique<Stmt::Expression>(std::move(increment))
+            arena.make<Stmt::Expression>(increment)
         );
 
-        body = std::make_unique<Stmt::Block>(std::move(statements));
+        body = arena.make<Stmt::Block>(arena.copy(statements));
     }
 
     if (condition == nullptr)
-        condition = std::make_unique<Expr::Literal>(true);
+        condition = arena.make<Expr::Literal>(constants.boolean(true));
 
-    body = std::make_unique<Stmt::While>
-        (std::move(condition),
-         std::move(body));
+    body = arena.make<Stmt::While>(condition,
+         body);
 
     if (initializer != nullptr) {
-        std::vector<std::unique_ptr<Stmt>> statements;
-        statements.push_back(std::move(initializer));
-        statements.push_back(std::move(body));
-        body = std::make_unique<Stmt::Block>(std::move(statements));
+        std::vector<Stmt*> statements;
+        statements.push_back(initializer);
+        statements.push_back(body);
+        body = arena.make<Stmt::Block>(arena.copy(statements));
     }
 
     return body;
 }
 
-std::vector<std::unique_ptr<Stmt>> Parser::block() {
-    std::vector<std::unique_ptr<Stmt>> statements;
+std::span<Stmt* const> Parser::block() {
+    std::vector<Stmt*> statements;
 
     while (!check(RIGHT_BRACE) && !isAtEnd()) {
         statements.push_back(declaration());
@@ -371,39 +512,38 @@ std::vector<std::unique_ptr<Stmt>> Parser::block() {
 
     consume(RIGHT_BRACE, "Expect '}' after block.");
 
-    return statements;
+    return arena.copy(statements);
 }
 
-std::unique_ptr<Stmt> Parser::ifStatement() {
+Stmt* Parser::ifStatement() {
     consume(LEFT_PAREN, "Expect '(' after 'if'.");
-    std::unique_ptr<Expr> condition = expression();
+    Expr* condition = expression();
     consume(RIGHT_PAREN, "Expect ')' after 'if'.");
 
-    std::unique_ptr<Stmt> thenBranch = statement();
-    std::unique_ptr<Stmt> elseBranch = nullptr;
+    Stmt* thenBranch = statement();
+    Stmt* elseBranch = nullptr;
 
     if (match({ELSE})) {
         elseBranch = statement();
     }
 
-    return std::make_unique<Stmt::If>
-    (
-        std::move(condition), 
-        std::move(thenBranch),
-        std::move(elseBranch)
+    return arena.make<Stmt::If>(
+        condition, 
+        thenBranch,
+        elseBranch
     );
 }
 
-std::unique_ptr<Stmt> Parser::printStatement() {
-    std::unique_ptr<Expr> value = expression();
+Stmt* Parser::printStatement() {
+    Expr* value = expression();
     consume(SEMICOLON, "Expect ';' after value");
 
-    return std::make_unique<Stmt::Print>(std::move(value));
+    return arena.make<Stmt::Print>(value);
 }
 
-std::unique_ptr<Stmt> Parser::returnStatement() {
+Stmt* Parser::returnStatement() {
     Token keyword = previous();
-    std::unique_ptr<Expr> value = nullptr;
+    Expr* value = nullptr;
 
     if (!check(SEMICOLON)) {
         value = expression();
@@ -411,41 +551,40 @@ std::unique_ptr<Stmt> Parser::returnStatement() {
 
     consume(SEMICOLON, "Expect ';' after return value");
 
-    return std::make_unique<Stmt::Return>(keyword, std::move(value));
+    return arena.make<Stmt::Return>(keyword, value);
 }
 
-std::unique_ptr<Stmt> Parser::varDeclaration() {
+Stmt* Parser::varDeclaration() {
     Token name = consume(IDENTIFIER, "Expect variable name.");
 
-    std::unique_ptr<Expr> initializer = nullptr;
+    Expr* initializer = nullptr;
 
     if (match({EQUAL})) {
         initializer = expression();
     }
 
     consume(SEMICOLON, "Expect ';' after variable declaration");
-    return std::make_unique<Stmt::Var>(name, std::move(initializer));
+    return arena.make<Stmt::Var>(name, initializer);
 }
 
-std::unique_ptr<Stmt> Parser::whileStatement() {
+Stmt* Parser::whileStatement() {
     consume(LEFT_PAREN, "Expect '(' after 'while'.");
-    std::unique_ptr<Expr> condition = expression();
+    Expr* condition = expression();
     consume(LEFT_PAREN, "Expect ')' after condition");
-    std::unique_ptr<Stmt> body = statement();
+    Stmt* body = statement();
 
-    return std::make_unique<Stmt::While>
-    (std::move(condition),
-     std::move(body));
+    return arena.make<Stmt::While>(condition,
+     body);
 }
 
-std::unique_ptr<Stmt> Parser::expressionStatement() {
-    std::unique_ptr<Expr> expr = expression();
+Stmt* Parser::expressionStatement() {
+    Expr* expr = expression();
     consume(SEMICOLON, "Expect ';' after expression");
 
-    return std::make_unique<Stmt::Expression>(std::move(expr));
+    return arena.make<Stmt::Expression>(expr);
 }
 
-bool Parser::match(std::vector<TokenType> types){
+bool Parser::match(std::initializer_list<TokenType> types){
     for(const TokenType& type: types) {
         if(check(type)) {
             advance();
@@ -456,7 +595,7 @@ bool Parser::match(std::vector<TokenType> types){
     return false;
 }
 
-std::unique_ptr<Stmt::Function> Parser::function(std::string kind) {
+Stmt::Function* Parser::function(std::string kind) {
     Token name = consume(IDENTIFIER, "Expect " + kind + " name.");
     consume(LEFT_PAREN, "Expect '(' after " + kind + " name.");
     
@@ -475,9 +614,9 @@ std::unique_ptr<Stmt::Function> Parser::function(std::string kind) {
 
     // Body
     consume(LEFT_BRACE, "Expect '{' before" + kind + " body.");
-    std::vector<std::unique_ptr<Stmt>> body = block();
+    std::span<Stmt* const> body = block();
 
-    return std::make_unique<Stmt::Function>(name, parameters, std::move(body));
+    return arena.make<Stmt::Function>(name, arena.copy(parameters), body);
 }
 
 // Advance if we have expected token
@@ -506,10 +645,23 @@ bool Parser::isAtEnd() {
 
 // Returns the next token
 Token Parser::peek() {
-    return tokens[current];
+    while (pulled <= current) {
+        window[pulled % LOOKAHEAD] = pull();
+        pulled++;
+    }
+
+    return window[current % LOOKAHEAD];
 }
 
 // Returns the previous token
 Token Parser::previous() {
-    return tokens[current-1];
+    return window[(current-1) % LOOKAHEAD];
+}
+
+// Fetches one more token from the source; repeats END_OF_FILE at the end
+Token Parser::pull() {
+    if (lexer) return lexer->nextToken();
+
+    if (nextIndex < tokens.size()) return tokens[nextIndex++];
+    return tokens.back();
 }
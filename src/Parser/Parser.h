@@ -5,72 +5,151 @@
 #include "../Runtime/Runtime.h"
 #include "../Runtime/Expr.h"
 #include "../Runtime/Stmt.h"
+#include "../Runtime/CompilationUnit.h"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
 #include <vector>
 #include <stdexcept>
-#include <memory>
+#include <span>
 #include <variant>
 
+class Lexer;
+
 class Parser {
 public:
+    // How expressions are parsed. Both build the same tree; the
+    // descent ladder is kept for comparison in the parser benchmark.
+    enum class Grammar { PRATT, LADDER };
+
     // Constructor
-    Parser(std::vector<Token> tokens): tokens(tokens){};
+    // Parse a pre-scanned token array
+    Parser(std::vector<Token> tokens, CompilationUnit& unit)
+        : tokens(std::move(tokens)), constants(unit.constants), arena(unit.arena){};
+    // Streaming: pull tokens from the lexer as the grammar needs them
+    Parser(Lexer& lexer, CompilationUnit& unit)
+        : lexer(&lexer), constants(unit.constants), arena(unit.arena){};
 
-    std::vector<std::unique_ptr<Stmt>> parse();
-    std::unique_ptr<Stmt> statement();
+    // Nodes are allocated in the unit's arena and live as long as it
+    std::span<Stmt* const> parse();
+    Stmt* statement();
     Value visitClassStmt(const Stmt::Class& stmt);
-    std::unique_ptr<Stmt> declaration();
-    std::unique_ptr<Stmt> classDeclaration();
-    std::unique_ptr<Stmt> ifStatement();
-    std::unique_ptr<Stmt> printStatement();
-    std::unique_ptr<Stmt> returnStatement();
-    std::unique_ptr<Stmt> varDeclaration();
-    std::unique_ptr<Stmt> forStatement();
-    std::unique_ptr<Stmt> whileStatement();
-    std::unique_ptr<Stmt> expressionStatement();
-    std::unique_ptr<Stmt::Function> function(std::string kind);
-    std::vector<std::unique_ptr<Stmt>> block();
+    Stmt* declaration();
+    Stmt* classDeclaration();
+    Stmt* ifStatement();
+    Stmt* printStatement();
+    Stmt* returnStatement();
+    Stmt* varDeclaration();
+    Stmt* forStatement();
+    Stmt* whileStatement();
+    Stmt* expressionStatement();
+    Stmt::Function* function(std::string kind);
+    std::span<Stmt* const> block();
+
+    void setGrammar(Grammar grammar) { this->grammar = grammar; }
 
 private:
-    // Array of Tokens
+    Grammar grammar = Grammar::PRATT;
+
+    // Token source: the lexer when streaming, else the array
+    Lexer* lexer = nullptr;
     std::vector<Token> tokens;
-    int current = 0;
+    std::size_t nextIndex = 0;
+
+    // Where literal values are interned and nodes allocated
+    ConstantPool& constants;
+    Arena& arena;
+
+    // The tokens around the cursor. Only previous() and peek() are ever
+    // looked at, so this window (not the file) bounds token memory.
+    static constexpr int LOOKAHEAD = 4;
+    std::array<Token, LOOKAHEAD> window;
+    int current = 0;   // Index of the next unconsumed token
+    int pulled = 0;    // Tokens pulled from the source so far
+
+    // ---------- Pratt parser ----------
+    // Binding power of infix operators, lowest first
+    enum class Precedence : std::uint8_t {
+        NONE,
+        ASSIGNMENT,  // =
+        OR,          // or
+        AND,         // and
+        EQUALITY,    // == !=
+        COMPARISON,  // < > <= >=
+        TERM,        // + -
+        FACTOR,      // * /
+        UNARY,       // ! -
+        CALL,        // . ()
+        PRIMARY
+    };
+
+    // Handlers run with the triggering token already consumed
+    using PrefixFn = Expr* (Parser::*)();
+    using InfixFn = Expr* (Parser::*)(Expr* left);
+
+    struct ParseRule {
+        PrefixFn prefix;
+        InfixFn infix;
+        Precedence precedence;
+    };
+
+    // One rule per TokenType
+    static const std::array<ParseRule, END_OF_FILE + 1> rules;
+
+    // Parse an expression whose operators bind at least as tightly as `precedence`
+    Expr* parsePrecedence(Precedence precedence);
+
+    Expr* literal();
+    Expr* variable();
+    Expr* thisExpr();
+    Expr* superExpr();
+    Expr* grouping();
+    Expr* prefixUnary();
+    Expr* binary(Expr* left);
+    Expr* logical(Expr* left);
+    Expr* assign(Expr* left);
+    Expr* callInfix(Expr* left);
+    Expr* dot(Expr* left);
 
     // Expression Grammar Function (Low -> High)
     //expression → assignment ;
-    std::unique_ptr<Expr> expression();
+    Expr* expression();
     // assignment → IDENTIFIER "=" assignment | equality;
-    std::unique_ptr<Expr> assignment();
+    Expr* assignment();
     // equality → comparison ( ( "!=" | "==" ) comparison )* ;
-    std::unique_ptr<Expr> equality();
+    Expr* equality();
     // logic_or → logic_and ( "or" logic_and )* ;
-    std::unique_ptr<Expr> logicOr();
+    Expr* logicOr();
     // logic_and → equality ( "and" equality )* ;
-    std::unique_ptr<Expr> logicAnd();
+    Expr* logicAnd();
     // comparison → term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
-    std::unique_ptr<Expr> comparison();
+    Expr* comparison();
     // term → factor ( ( "-" | "+" ) factor )* ;
-    std::unique_ptr<Expr> term();
+    Expr* term();
     // factor → unary ( ( "/" | "*" ) unary )* ;
-    std::unique_ptr<Expr> factor();
+    Expr* factor();
     // unary → ( "!" | "-" ) unary | call ;
-    std::unique_ptr<Expr> unary();
+    Expr* unary();
     // call → primary ( "(" arguments? ")" )* ;
-    std::unique_ptr<Expr> call();
+    Expr* call();
     // arguments → expression ( "," expression )* ;
-    // primary → NUMBER | STRING | "true" | "false" | "nil" | "(" expression ")" ;
-    std::unique_ptr<Expr> primary();
+    // primary → NUMBER | STRING | "true" | "false" | "nil" | "this"
+    //         | "super" "." IDENTIFIER | "(" expression ")" | IDENTIFIER ;
+    Expr* primary();
 
     // Helper Function
-    std::unique_ptr<Expr> finishCall(std::unique_ptr<Expr>& callee);
-    bool match(std::vector<TokenType> types);
+    Expr* finishCall(Expr*& callee);
+    bool match(std::initializer_list<TokenType> types);
     bool check(TokenType type);
     bool isAtEnd();
     Token consume(TokenType type, std::string message);
     Token advance();
     Token peek();
     Token previous();
+    Token pull();
 
     // Nested Private Class
     class ParseError: public std::runtime_error {
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator backing a CompilationUnit's AST. Nodes and their child
+// lists are carved out of large chunks in allocation order, so a tree
+// sits in a few contiguous blocks and is released in one go when the
+// arena dies. Destructors are never run, which is why only trivially
+// destructible types may be placed here.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "Arena never runs destructors");
+
+        void* memory = allocate(sizeof(T), alignof(T));
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    // Copy a list built during parsing into the arena
+    template <typename T>
+    std::span<const T> copy(const std::vector<T>& items) {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        if (items.empty()) return {};
+
+        void* memory = allocate(sizeof(T) * items.size(), alignof(T));
+        T* array = static_cast<T*>(memory);
+        std::uninitialized_copy(items.begin(), items.end(), array);
+
+        return {array, items.size()};
+    }
+
+    void* allocate(std::size_t size, std::size_t align) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(cursor);
+        std::uintptr_t aligned = (address + align - 1) & ~(std::uintptr_t(align) - 1);
+
+        if (cursor == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(limit)) {
+            grow(size + align);
+            address = reinterpret_cast<std::uintptr_t>(cursor);
+            aligned = (address + align - 1) & ~(std::uintptr_t(align) - 1);
+        }
+
+        cursor = reinterpret_cast<char*>(aligned + size);
+        used += size;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    // Bytes handed out / bytes reserved from the system
+    std::size_t bytesUsed() const { return used; }
+    std::size_t bytesReserved() const { return reserved; }
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    std::size_t used = 0;
+    std::size_t reserved = 0;
+
+    void grow(std::size_t atLeast) {
+        std::size_t size = atLeast > CHUNK_SIZE ? atLeast : CHUNK_SIZE;
+
+        chunks.push_back(std::make_unique_for_overwrite<char[]>(size));
+        cursor = chunks.back().get();
+        limit = cursor + size;
+        reserved += size;
+    }
+};
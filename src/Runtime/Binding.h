@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Where a resolved name lives at run time, filled in by the Resolver.
+//
+// LOCAL and CELL index the running call's frame; a CELL is a local that
+// a closure captures and something also assigns (or a function that
+// refers to itself), so it is boxed and shared. UPVALUE and
+// UPVALUE_CELL index the running function's captured values and cells.
+struct Binding {
+    enum class Kind : std::uint8_t { GLOBAL, LOCAL, CELL, UPVALUE, UPVALUE_CELL };
+
+    Kind kind = Kind::GLOBAL;
+    int index = -1;
+
+    bool operator==(const Binding&) const = default;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../Interpreter/RuntimeError.h"
+#include "../Token/Token.h"
+
+// How deeply calls may nest, shared by every engine so a script either
+// overflows on all of them or on none. A call counts from once its
+// arguments are evaluated until it returns. The tree-walker and the
+// closure engine recurse natively for each call, so the limit is kept
+// well inside the native stack.
+class CallDepth {
+public:
+    static constexpr int MAX = 1024;
+    static constexpr const char* MESSAGE = "Stack overflow.";
+
+    // Counts one call in `depth` for as long as it is in scope, including
+    // when a runtime error unwinds it; reports the call at `paren` if it
+    // would go past MAX
+    CallDepth(int& depth, const Token& paren) : depth(depth) {
+        if (depth == MAX) throw RuntimeError(paren, MESSAGE);
+        depth++;
+    }
+
+    ~CallDepth() { depth--; }
+
+    CallDepth(const CallDepth&) = delete;
+    CallDepth& operator=(const CallDepth&) = delete;
+
+private:
+    int& depth;
+};
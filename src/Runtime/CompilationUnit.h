@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Stmt.h"
+#include "SourceBuffer.h"
+#include "ConstantPool.h"
+#include "Arena.h"
+
+#include <memory>
+#include <span>
+#include <string_view>
+
+// Owns everything produced from one piece of source text: the text
+// itself, which tokens and AST nodes reference by view, the literal
+// constants and the arena holding the AST.
+// Units are kept alive by the Runtime for as long as the interpreter
+// may still reach into them (functions hold pointers to their
+// declarations, whose resolved bindings and capture lists live here).
+class CompilationUnit {
+public:
+    explicit CompilationUnit(std::unique_ptr<SourceBuffer> source)
+        : source(std::move(source)) {}
+
+    CompilationUnit(const CompilationUnit&) = delete;
+    CompilationUnit& operator=(const CompilationUnit&) = delete;
+
+    std::string_view text() const { return source->text(); }
+
+    ConstantPool constants;
+    Arena arena;
+    std::span<Stmt* const> statements;
+
+private:
+    std::unique_ptr<SourceBuffer> source;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Value.h"
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Literal values of one CompilationUnit. Each distinct number or
+// string is stored once and every Expr::Literal spelling it refers
+// to that copy. Entries never move, so handing out references is safe
+// for as long as the pool lives.
+class ConstantPool {
+public:
+    const Value& number(double value) {
+        // Key by bit pattern so -0 and 0 (and NaNs) stay distinct
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+
+        auto it = numbers.find(bits);
+        if (it != numbers.end()) return *it->second;
+
+        const Value& constant = constants.emplace_back(value);
+        numbers.emplace(bits, &constant);
+        return constant;
+    }
+
+    const Value& string(std::string_view text) {
+        auto it = strings.find(text);
+        if (it != strings.end()) return *it->second;
+
+        const Value& constant = constants.emplace_back(LoxString::intern(text));
+        // The key views the interned copy, not the caller's buffer
+        strings.emplace(constant.asString().view(), &constant);
+        return constant;
+    }
+
+    const Value& boolean(bool value) { return value ? trueValue : falseValue; }
+    const Value& nil() { return nilValue; }
+
+    std::size_t size() const { return constants.size(); }
+
+private:
+    std::deque<Value> constants;
+    std::unordered_map<std::uint64_t, const Value*> numbers;
+    std::unordered_map<std::string_view, const Value*> strings;
+
+    const Value trueValue = true;
+    const Value falseValue = false;
+    const Value nilValue = std::monostate{};
+};
@@ -2,12 +2,12 @@
 
 #include "../Token/Token.h"
 #include "../Runtime/Value.h"
+#include "../Runtime/Binding.h"
+#include "../Runtime/Shape.h"
 
 #include <variant>
-#include <memory>
+#include <span>
 #include <string>
-#include <any>
-#include <vector>
 
 class Expr {
 public:
@@ -22,6 +22,8 @@ public:
     class Call;
     class Get;
     class Set;
+    class This;
+    class Super;
 
     // Visitor Function 
     struct Visitor {
@@ -35,25 +37,31 @@ public:
         virtual Value visitCallExpr(const Call& expr) { return {}; };
         virtual Value visitGetExpr(const Get& expr) { return {}; };
         virtual Value visitSetExpr(const Set& expr) { return {}; };
+        virtual Value visitThisExpr(const This& expr) { return {}; };
+        virtual Value visitSuperExpr(const Super& expr) { return {}; };
 
         virtual ~Visitor() = default;
     };
 
-    virtual ~Expr() = default;
-
     virtual Value accept(Visitor& visitor) const = 0;
+
+protected:
+    // Nodes live in the unit's Arena and are never destroyed one by
+    // one; keeping this non-virtual keeps them trivially destructible
+    ~Expr() = default;
 };
 
 // ------------------ AST Nodes ------------------
+// Child nodes and lists are owned by the Arena, not by their parent.
 
 class Expr::Binary : public Expr {
 public:
-    Binary(std::unique_ptr<Expr> left, Token operator_, std::unique_ptr<Expr> right)
-        : left(std::move(left)), operator_(operator_), right(std::move(right)) {}
+    Binary(Expr* left, Token operator_, Expr* right)
+        : left(left), operator_(operator_), right(right) {}
 
-    std::unique_ptr<Expr> left;
+    Expr* left;
     Token operator_;
-    std::unique_ptr<Expr> right;
+    Expr* right;
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -63,10 +71,10 @@ public:
 
 class Expr::Grouping : public Expr {
 public:
-    explicit Grouping(std::unique_ptr<Expr> expression)
-        : expression(std::move(expression)) {}
+    explicit Grouping(Expr* expression)
+        : expression(expression) {}
 
-    std::unique_ptr<Expr> expression;
+    Expr* expression;
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -76,24 +84,30 @@ public:
 
 class Expr::Literal : public Expr {
 public:
-    explicit Literal(Value value)
+    // The value lives in the unit's ConstantPool, shared by every
+    // literal with the same spelling
+    explicit Literal(const Value& value)
         : value(value) {}
 
-    Value value;
+    const Value& value;
 
     // stringify
     std::string toString() const {
-        if (std::holds_alternative<std::monostate>(value)) 
+        return toString(value);
+    }
+
+    static std::string toString(const Value& value) {
+        if (value.isNil()) 
             return "nil";
 
-        if (auto d = std::get_if<double>(&value))
-            return std::to_string(*d);
+        if (value.isNumber())
+            return std::to_string(value.asNumber());
 
-        if (auto s = std::get_if<std::string>(&value))
-            return *s;
+        if (value.isString())
+            return std::string(value.asString().view());
 
-        if (auto b = std::get_if<bool>(&value))
-            return *b ? "true" : "false";
+        if (value.isBool())
+            return value.asBool() ? "true" : "false";
 
         return "nil";
     }
@@ -107,10 +121,10 @@ public:
 class Expr::Unary : public Expr {
 public:
     Token operator_;
-    std::unique_ptr<Expr> right;
+    Expr* right;
 
-    Unary(Token operator_, std::unique_ptr<Expr> right)
-        : operator_(operator_), right(std::move(right)) {}
+    Unary(Token operator_, Expr* right)
+        : operator_(operator_), right(right) {}
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -121,6 +135,8 @@ public:
 class Expr::Variable : public Expr {
 public:
     Token name;
+    // Set by the Resolver
+    mutable Binding binding;
 
     Variable(Token name)
         : name(name) {}
@@ -134,10 +150,12 @@ public:
 class Expr::Assign : public Expr {
 public:
     Token name;
-    std::unique_ptr<Expr> value;
+    Expr* value;
+    // Set by the Resolver
+    mutable Binding binding;
 
-    Assign(Token name, std::unique_ptr<Expr> value)
-        : name(name), value(std::move(value)) {}
+    Assign(Token name, Expr* value)
+        : name(name), value(value) {}
 
 
     // Override
@@ -148,16 +166,16 @@ public:
 
 class Expr::Logical: public Expr {
 public:
-    std::unique_ptr<Expr> left;
+    Expr* left;
     Token operator_;
-    std::unique_ptr<Expr> right;
+    Expr* right;
 
-    Logical(std::unique_ptr<Expr> left, 
+    Logical(Expr* left, 
             Token operator_,
-            std::unique_ptr<Expr> right)
-        :left(std::move(left)),
-        operator_(std::move(operator_)),
-        right(std::move(right)) {}
+            Expr* right)
+        :left(left),
+        operator_(operator_),
+        right(right) {}
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -167,16 +185,26 @@ public:
 
 class Expr::Call: public Expr {
 public:
-    std::unique_ptr<Expr> callee;
+    Expr* callee;
     Token paren;
-    std::vector<std::unique_ptr<Expr>> arguments;
-
-    Call(std::unique_ptr<Expr> callee, 
+    std::span<Expr* const> arguments;
+    // The callee again when it is a property, `obj.name(...)`: a method
+    // found there is invoked on obj directly, without binding it first
+    Get* property;
+    mutable MethodCache cache;
+    // Likewise for `super.name(...)`, invoked on `this`
+    Super* superMethod;
+
+    Call(Expr* callee, 
             Token paren,
-            std::vector<std::unique_ptr<Expr>> arguments)
-        :callee(std::move(callee)),
-        paren(std::move(paren)),
-        arguments(std::move(arguments)) {}
+            std::span<Expr* const> arguments,
+            Get* property = nullptr,
+            Super* superMethod = nullptr)
+        :callee(callee),
+        paren(paren),
+        arguments(arguments),
+        property(property),
+        superMethod(superMethod) {}
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -186,13 +214,14 @@ public:
 
 class Expr::Get: public Expr {
 public:
-    std::unique_ptr<Expr> receiver;
+    Expr* receiver;
     Token name;
+    mutable PropertyCache cache;
 
-    Get(std::unique_ptr<Expr> receiver, 
+    Get(Expr* receiver, 
         Token name)
-        :receiver(std::move(receiver)),
-        name(std::move(name)) {}
+        :receiver(receiver),
+        name(name) {}
 
     // Override
     Value accept(Visitor& visitor) const override {
@@ -202,19 +231,57 @@ public:
 
 class Expr::Set: public Expr {
 public:
-    std::unique_ptr<Expr> receiver;
+    Expr* receiver;
     Token name;
-    std::unique_ptr<Expr> value;
+    Expr* value;
+    mutable PropertyCache cache;
 
-    Set(std::unique_ptr<Expr> receiver, 
+    Set(Expr* receiver, 
         Token name,
-        std::unique_ptr<Expr> value)
-        :receiver(std::move(receiver)),
-        name(std::move(name)),
-        value(std::move(value)) {}
+        Expr* value)
+        :receiver(receiver),
+        name(name),
+        value(value) {}
 
     // Override
     Value accept(Visitor& visitor) const override {
         return visitor.visitSetExpr(*this);
     }
 };
+
+class Expr::This: public Expr {
+public:
+    Token keyword;
+    // Set by the Resolver
+    mutable Binding binding;
+
+    This(Token keyword)
+        :keyword(keyword) {}
+
+    // Override
+    Value accept(Visitor& visitor) const override {
+        return visitor.visitThisExpr(*this);
+    }
+};
+
+class Expr::Super: public Expr {
+public:
+    Token keyword;
+    Token method;
+    // Set by the Resolver: the superclass, which every subclass keeps
+    // in a variable named `super` around its methods, and the receiver
+    mutable Binding binding;
+    mutable Binding thisBinding;
+    // Keyed by the superclass alone; its flattened method table never
+    // changes once the class is defined
+    mutable MethodCache cache;
+
+    Super(Token keyword, Token method)
+        :keyword(keyword),
+        method(method) {}
+
+    // Override
+    Value accept(Visitor& visitor) const override {
+        return visitor.visitSuperExpr(*this);
+    }
+};
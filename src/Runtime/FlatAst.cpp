@@ -0,0 +1,346 @@
+#include "FlatAst.h"
+#include "Runtime.h"
+
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+// ---------- Builder ----------
+// Lowers the pointer tree bottom-up: children are appended first and
+// each visit leaves the index of the node it emitted in `result`.
+class FlatAst::Builder : public Expr::Visitor, public Stmt::Visitor {
+public:
+    FlatAst flat;
+
+    Index build(const Expr* expr) {
+        if (expr == nullptr) return NONE;
+        expr->accept(*this);
+        return result;
+    }
+
+    Index build(const Stmt* stmt) {
+        if (stmt == nullptr) return NONE;
+        stmt->accept(*this);
+        return result;
+    }
+
+    Index buildList(std::span<Stmt* const> statements) {
+        std::vector<Index> items;
+        items.reserve(statements.size());
+
+        for (const Stmt* stmt : statements) items.push_back(build(stmt));
+        return appendList(items);
+    }
+
+    Value visitBinaryExpr(const Expr::Binary& expr) override {
+        Index left = build(expr.left);
+        Index right = build(expr.right);
+        return emit(Kind::BINARY, addToken(expr.operator_), left, right);
+    }
+
+    Value visitGroupingExpr(const Expr::Grouping& expr) override {
+        return emit(Kind::GROUPING, NONE, build(expr.expression), NONE);
+    }
+
+    Value visitLiteralExpr(const Expr::Literal& expr) override {
+        // Pooled literals share a Value, so they share a slot here too
+        auto [it, inserted] = constantIndex.try_emplace(
+            &expr.value, static_cast<Index>(flat.constants.size()));
+        if (inserted) flat.constants.push_back(&expr.value);
+
+        return emit(Kind::LITERAL, NONE, it->second, NONE);
+    }
+
+    Value visitUnaryExpr(const Expr::Unary& expr) override {
+        Index right = build(expr.right);
+        return emit(Kind::UNARY, addToken(expr.operator_), right, NONE);
+    }
+
+    Value visitVarExpr(const Expr::Variable& expr) override {
+        return emit(Kind::VARIABLE, addToken(expr.name), NONE, NONE);
+    }
+
+    Value visitAssignExpr(const Expr::Assign& expr) override {
+        Index value = build(expr.value);
+        return emit(Kind::ASSIGN, addToken(expr.name), value, NONE);
+    }
+
+    Value visitLogicalExpr(const Expr::Logical& expr) override {
+        Index left = build(expr.left);
+        Index right = build(expr.right);
+        return emit(Kind::LOGICAL, addToken(expr.operator_), left, right);
+    }
+
+    Value visitCallExpr(const Expr::Call& expr) override {
+        Index callee = build(expr.callee);
+
+        std::vector<Index> arguments;
+        for (const Expr* argument : expr.arguments) arguments.push_back(build(argument));
+
+        Index list = appendList(arguments);
+        return emit(Kind::CALL, addToken(expr.paren), callee, list);
+    }
+
+    Value visitGetExpr(const Expr::Get& expr) override {
+        Index receiver = build(expr.receiver);
+        return emit(Kind::GET, addToken(expr.name), receiver, NONE);
+    }
+
+    Value visitSetExpr(const Expr::Set& expr) override {
+        Index receiver = build(expr.receiver);
+        Index value = build(expr.value);
+        return emit(Kind::SET, addToken(expr.name), receiver, value);
+    }
+
+    Value visitThisExpr(const Expr::This& expr) override {
+        return emit(Kind::THIS, addToken(expr.keyword), NONE, NONE);
+    }
+
+    Value visitSuperExpr(const Expr::Super& expr) override {
+        return emit(Kind::SUPER, addToken(expr.keyword), addToken(expr.method), NONE);
+    }
+
+    Value visitExpressionStmt(const Stmt::Expression& stmt) override {
+        return emit(Kind::EXPRESSION, NONE, build(stmt.expression), NONE);
+    }
+
+    Value visitPrintStmt(const Stmt::Print& stmt) override {
+        return emit(Kind::PRINT, NONE, build(stmt.expression), NONE);
+    }
+
+    Value visitVarStmt(const Stmt::Var& stmt) override {
+        Index initializer = build(stmt.initializer);
+        return emit(Kind::VAR, addToken(stmt.name), initializer, NONE);
+    }
+
+    Value visitBlockStmt(const Stmt::Block& stmt) override {
+        return emit(Kind::BLOCK, NONE, buildList(stmt.statements), NONE);
+    }
+
+    Value visitIfStmt(const Stmt::If& stmt) override {
+        Index condition = build(stmt.condition);
+        Index branches = appendList({build(stmt.thenBranch), build(stmt.elseBranch)});
+        return emit(Kind::IF, NONE, condition, branches);
+    }
+
+    Value visitWhileStmt(const Stmt::While& stmt) override {
+        Index condition = build(stmt.condition);
+        Index body = build(stmt.body);
+        return emit(Kind::WHILE, NONE, condition, body);
+    }
+
+    Value visitFunctionStmt(const Stmt::Function& stmt) override {
+        std::vector<Index> params;
+        for (const Token& param : stmt.params) params.push_back(addToken(param));
+
+        Index paramList = appendList(params);
+        Index body = buildList(stmt.body);
+        return emit(Kind::FUNCTION, addToken(stmt.name), paramList, body);
+    }
+
+    Value visitReturnStmt(const Stmt::Return& stmt) override {
+        Index value = build(stmt.value);
+        return emit(Kind::RETURN, addToken(stmt.keyword), value, NONE);
+    }
+
+    Value visitClassStmt(const Stmt::Class& stmt) override {
+        Index superclass = build(stmt.superclass);
+
+        std::vector<Index> methods;
+        for (const Stmt::Function* method : stmt.methods) methods.push_back(build(method));
+
+        Index list = appendList(methods);
+        return emit(Kind::CLASS, addToken(stmt.name), superclass, list);
+    }
+
+private:
+    Index result = NONE;
+    std::unordered_map<const Value*, Index> constantIndex;
+
+    Value emit(Kind kind, Index token, Index a, Index b) {
+        result = static_cast<Index>(flat.kinds.size());
+
+        flat.kinds.push_back(kind);
+        flat.tokens.push_back(token);
+        flat.a.push_back(a);
+        flat.b.push_back(b);
+
+        return std::monostate{};
+    }
+
+    Index addToken(const Token& token) {
+        FlatToken compact;
+        compact.offset = static_cast<std::uint32_t>(token.lexeme.data() - flat.source.data());
+        compact.line = static_cast<std::uint32_t>(token.line);
+        bool named = token.type == TokenType::IDENTIFIER || token.type == TokenType::THIS ||
+                     token.type == TokenType::SUPER;
+        compact.symbol = named ? token.symbol : -1;
+        compact.length = static_cast<std::uint32_t>(token.lexeme.size());
+        compact.type = static_cast<std::uint8_t>(token.type);
+
+        flat.tokenTable.push_back(compact);
+        return static_cast<Index>(flat.tokenTable.size() - 1);
+    }
+
+    Index appendList(const std::vector<Index>& items) {
+        Index at = static_cast<Index>(flat.extra.size());
+
+        flat.extra.push_back(static_cast<Index>(items.size()));
+        flat.extra.insert(flat.extra.end(), items.begin(), items.end());
+
+        return at;
+    }
+};
+
+FlatAst FlatAst::build(std::span<Stmt* const> statements, std::string_view source) {
+    Builder builder;
+    builder.flat.source = source;
+
+    // Token offsets and lengths are 32-bit
+    if (source.size() > std::numeric_limits<std::uint32_t>::max()) {
+        Runtime::error(0, "Source too large for the flat AST (over 4 GB).");
+        statements = {};
+    }
+
+    builder.flat.program = builder.buildList(statements);
+
+    FlatAst flat = std::move(builder.flat);
+    flat.kinds.shrink_to_fit();
+    flat.tokens.shrink_to_fit();
+    flat.a.shrink_to_fit();
+    flat.b.shrink_to_fit();
+    flat.extra.shrink_to_fit();
+    flat.tokenTable.shrink_to_fit();
+    flat.constants.shrink_to_fit();
+    return flat;
+}
+
+std::size_t FlatAst::bytes() const {
+    return kinds.capacity() * sizeof(Kind) +
+           tokens.capacity() * sizeof(Index) +
+           a.capacity() * sizeof(Index) +
+           b.capacity() * sizeof(Index) +
+           extra.capacity() * sizeof(Index) +
+           tokenTable.capacity() * sizeof(FlatToken) +
+           constants.capacity() * sizeof(const Value*);
+}
+
+Token FlatAst::expand(const FlatToken& token) const {
+    Token full(static_cast<TokenType>(token.type),
+               source.substr(token.offset, token.length),
+               static_cast<int>(token.line));
+    if (full.type == TokenType::IDENTIFIER || full.type == TokenType::THIS ||
+        full.type == TokenType::SUPER)
+        full.symbol = token.symbol;
+    return full;
+}
+
+// ---------- Printer ----------
+void FlatAst::print() const {
+    for (Index stmt : list(program)) {
+        std::cout << print(stmt) << "\n";
+    }
+}
+
+std::string FlatAst::print(Index node) const {
+    switch (kinds[node]) {
+        case Kind::BINARY:
+        case Kind::LOGICAL:
+            return parenthesize(std::string(token(node).lexeme), {a[node], b[node]});
+
+        case Kind::GROUPING:
+            return parenthesize("group", {a[node]});
+
+        case Kind::LITERAL:
+            return Expr::Literal::toString(*constants[a[node]]);
+
+        case Kind::UNARY:
+            return parenthesize(std::string(token(node).lexeme), {a[node]});
+
+        case Kind::VARIABLE:
+        case Kind::THIS:
+            return std::string(token(node).lexeme);
+
+        case Kind::ASSIGN:
+            return parenthesize("= " + std::string(token(node).lexeme), {a[node]});
+
+        case Kind::CALL: {
+            std::string result = "(call " + print(a[node]);
+            for (Index argument : list(b[node]))
+                result += " " + print(argument);
+            return result + ")";
+        }
+
+        case Kind::SUPER:
+            return "(super " + std::string(expand(tokenTable[a[node]]).lexeme) + ")";
+
+        case Kind::GET:
+            return "(. " + print(a[node]) + " " + std::string(token(node).lexeme) + ")";
+
+        case Kind::SET:
+            return "(= (. " + print(a[node]) + " " + std::string(token(node).lexeme) + ") " +
+                   print(b[node]) + ")";
+
+        case Kind::EXPRESSION:
+            return print(a[node]);
+
+        case Kind::PRINT:
+            return parenthesize("print", {a[node]});
+
+        case Kind::VAR:
+            if (a[node] != NONE)
+                return parenthesize("var " + std::string(token(node).lexeme), {a[node]});
+            return "(var " + std::string(token(node).lexeme) + ")";
+
+        case Kind::BLOCK:
+            return printBlock("(block", a[node]) + ")";
+
+        case Kind::IF: {
+            std::span<const Index> branches = list(b[node]);
+            std::string result = "(if " + print(a[node]) + " " + print(branches[0]);
+            if (branches[1] != NONE)
+                result += " " + print(branches[1]);
+            return result + ")";
+        }
+
+        case Kind::WHILE:
+            return "(while " + print(a[node]) + " " + print(b[node]) + ")";
+
+        case Kind::FUNCTION: {
+            std::string result = "(fun " + std::string(token(node).lexeme) + "(";
+            std::span<const Index> params = list(a[node]);
+            for (std::size_t i = 0; i < params.size(); i++) {
+                if (i > 0) result += " ";
+                result += std::string(expand(tokenTable[params[i]]).lexeme);
+            }
+            return printBlock(result + ") (block", b[node]) + "))";
+        }
+
+        case Kind::RETURN:
+            if (a[node] != NONE)
+                return parenthesize("return", {a[node]});
+            return "(return)";
+
+        case Kind::CLASS:
+            return printBlock("(class " + std::string(token(node).lexeme), b[node]) + ")";
+    }
+
+    return "(unknown)";
+}
+
+std::string FlatAst::parenthesize(const std::string& name, std::initializer_list<Index> nodes) const {
+    std::string builder = "(" + name;
+    for (Index node : nodes) {
+        builder += " ";
+        builder += print(node);
+    }
+    builder += ")";
+    return builder;
+}
+
+std::string FlatAst::printBlock(const std::string& head, Index statements) const {
+    std::string result = head;
+    for (Index stmt : list(statements))
+        result += " " + print(stmt);
+    return result;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Expr.h"
+#include "Stmt.h"
+#include "../Token/Token.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact, index-based encoding of a unit's AST, which the bytecode
+// compiler lowers from.
+//
+// Nodes are rows of a struct-of-arrays table addressed by 32-bit
+// indices: a one-byte kind tag, the index of the node's token in a
+// shared token table, and two operand columns. Children are emitted
+// before their parents, so a subtree occupies a contiguous index
+// range and a traversal walks the columns mostly front to back.
+// Tokens are kept as 20-byte records pointing into the unit's source
+// rather than as full Tokens, so a source can be at most 4 GB.
+//
+// Operand meaning by kind (NONE where absent):
+//   BINARY, LOGICAL   a = left,       b = right          token = operator
+//   UNARY             a = operand                        token = operator
+//   GROUPING          a = expression
+//   LITERAL           a = constant index
+//   VARIABLE                                             token = name
+//   ASSIGN            a = value                          token = name
+//   CALL              a = callee,     b = argument list  token = paren
+//   GET               a = receiver                       token = name
+//   SET               a = receiver,   b = value          token = name
+//   THIS                                                 token = keyword
+//   SUPER             a = method name token              token = keyword
+//   EXPRESSION, PRINT a = expression
+//   VAR               a = initializer                    token = name
+//   BLOCK             a = statement list
+//   IF                a = condition,  b = list [then, else]
+//   WHILE             a = condition,  b = body
+//   FUNCTION          a = parameter token list, b = body list  token = name
+//   RETURN            a = value                          token = keyword
+//   CLASS             a = superclass, b = method list    token = name
+//
+// A list operand indexes `extra`, which holds the element count
+// followed by the elements (node or token indices).
+class FlatAst {
+public:
+    using Index = std::uint32_t;
+    static constexpr Index NONE = 0xFFFFFFFFu;
+
+    enum class Kind : std::uint8_t {
+        // Expressions
+        BINARY, GROUPING, LITERAL, UNARY, VARIABLE,
+        ASSIGN, LOGICAL, CALL, GET, SET, THIS, SUPER,
+        // Statements
+        EXPRESSION, PRINT, VAR, BLOCK, IF,
+        WHILE, FUNCTION, RETURN, CLASS
+    };
+
+    struct FlatToken {
+        std::uint32_t offset;   // Lexeme position in the source
+        std::uint32_t line;
+        std::int32_t symbol;    // SymbolTable id for names, `this` and `super`
+        std::uint32_t length;
+        std::uint8_t type;      // TokenType
+    };
+
+    // Encode a parsed (error-free) program scanned from `source`. A
+    // source over 4 GB is reported and encodes as an empty program
+    static FlatAst build(std::span<Stmt* const> statements, std::string_view source);
+
+    // Columns
+    std::vector<Kind> kinds;
+    std::vector<Index> tokens;
+    std::vector<Index> a;
+    std::vector<Index> b;
+
+    std::vector<Index> extra;
+    std::vector<FlatToken> tokenTable;
+    std::string_view source;
+    std::vector<const Value*> constants;
+    // Top-level statements
+    Index program = NONE;
+
+    std::size_t size() const { return kinds.size(); }
+
+    std::span<const Index> list(Index at) const {
+        return {extra.data() + at + 1, extra[at]};
+    }
+
+    Token token(Index node) const { return expand(tokenTable[tokens[node]]); }
+    Token expand(const FlatToken& token) const;
+
+    // Bytes held by all tables
+    std::size_t bytes() const;
+
+    // Same s-expressions as AstPrinter, which the flat form can be
+    // checked against; also covers the nodes AstPrinter skips
+    std::string print(Index node) const;
+    void print() const;
+
+private:
+    std::string parenthesize(const std::string& name, std::initializer_list<Index> nodes) const;
+    std::string printBlock(const std::string& head, Index statements) const;
+
+    class Builder;
+};
@@ -0,0 +1,147 @@
+#include "Heap.h"
+
+#include "Value.h"
+#include "../Include/LoxCallable.h"
+#include "../Include/LoxInstance.h"
+
+#include <algorithm>
+#include <chrono>
+
+Heap::State& Heap::state() {
+    static State instance;
+    return instance;
+}
+
+Heap::State::~State() {
+    while (objects != nullptr) {
+        GcObject* next = objects->next;
+        delete objects;
+        objects = next;
+    }
+}
+
+// ---------- Roots ----------
+Heap::Roots::Roots(std::function<void()> mark) : markRoots(std::move(mark)) {
+    state().roots.push_back(this);
+}
+
+Heap::Roots::~Roots() {
+    std::vector<Roots*>& roots = state().roots;
+    roots.erase(std::find(roots.begin(), roots.end(), this));
+}
+
+// ---------- Allocation ----------
+void Heap::track(GcObject* object, std::size_t size) {
+    State& heap = state();
+
+    object->size = static_cast<std::uint32_t>(size);
+    object->next = heap.objects;
+    heap.objects = object;
+
+    Stats& stats = heap.stats;
+    stats.objectsAllocated++;
+    stats.bytesAllocated += size;
+    stats.liveObjects++;
+    stats.liveBytes += size;
+    stats.peakBytes = std::max(stats.peakBytes, stats.liveBytes);
+
+    if (heap.stress || stats.liveBytes > heap.threshold) {
+        // Nothing references the new object yet
+        mark(object);
+        collect();
+    }
+}
+
+void Heap::setStress(bool enabled) {
+    state().stress = enabled;
+}
+
+const Heap::Stats& Heap::stats() {
+    return state().stats;
+}
+
+// ---------- Collection ----------
+void Heap::collect() {
+    State& heap = state();
+    if (heap.collecting) return;
+    heap.collecting = true;
+
+    auto start = std::chrono::steady_clock::now();
+
+    markRoots();
+    traceReferences();
+    sweep();
+
+    heap.threshold = std::max(heap.stats.liveBytes * GROWTH_FACTOR, MIN_THRESHOLD);
+
+    double pause = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    heap.stats.collections++;
+    heap.stats.pauseSeconds += pause;
+    heap.stats.maxPauseSeconds = std::max(heap.stats.maxPauseSeconds, pause);
+
+    heap.collecting = false;
+}
+
+void Heap::mark(const Value& value) {
+    if (value.isCallable())
+        mark(value.asCallable());
+    else if (value.isInstance())
+        mark(value.asInstance());
+}
+
+void Heap::markRoots() {
+    State& heap = state();
+
+    for (Roots* roots : heap.roots) {
+        roots->markRoots();
+    }
+
+    for (const Temporary& temporary : heap.temporaries) {
+        switch (temporary.kind) {
+        case Temporary::Kind::VALUE:
+            mark(*static_cast<const Value*>(temporary.pointer));
+            break;
+        case Temporary::Kind::VALUES:
+            for (const Value& value : *static_cast<const std::vector<Value>*>(temporary.pointer))
+                mark(value);
+            break;
+        case Temporary::Kind::OBJECT:
+            mark(static_cast<const GcObject*>(temporary.pointer));
+            break;
+        }
+    }
+}
+
+void Heap::traceReferences() {
+    std::vector<const GcObject*>& gray = state().gray;
+
+    while (!gray.empty()) {
+        const GcObject* object = gray.back();
+        gray.pop_back();
+        object->trace();
+    }
+}
+
+void Heap::sweep() {
+    State& heap = state();
+    GcObject** link = &heap.objects;
+
+    while (*link != nullptr) {
+        GcObject* object = *link;
+
+        if (object->marked) {
+            object->marked = false;
+            link = &object->next;
+            continue;
+        }
+
+        *link = object->next;
+
+        heap.stats.objectsFreed++;
+        heap.stats.bytesFreed += object->size;
+        heap.stats.liveObjects--;
+        heap.stats.liveBytes -= object->size;
+
+        delete object;
+    }
+}
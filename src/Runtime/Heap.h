@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "Value.h"
+
+// Header of every object the collector manages: functions, classes,
+// instances and the engines' captured-variable boxes and scopes.
+// Subclasses mark what they reference from trace().
+class GcObject {
+public:
+    GcObject() = default;
+    // A copy is a new object with a header of its own
+    GcObject(const GcObject&) {}
+    GcObject& operator=(const GcObject&) { return *this; }
+    virtual ~GcObject() = default;
+
+    virtual void trace() const {}
+
+private:
+    friend class Heap;
+
+    GcObject* next = nullptr;
+    std::uint32_t size = 0;
+    mutable bool marked = false;
+};
+
+// Process-wide mark-sweep collector. Objects are created with make()
+// and never freed explicitly; a collection runs once the bytes
+// allocated since the last one pass a threshold that grows with the
+// live heap (or on every allocation under stress mode), marks from the
+// registered roots and frees the rest. Cycles, such as a closure stored
+// in a variable it captures, are collected like anything else.
+//
+// Lox strings are not managed here: they cannot form cycles, so they
+// stay reference counted and are only ever reached through Values.
+class Heap {
+public:
+    struct Stats {
+        std::size_t collections = 0;
+        std::size_t objectsAllocated = 0;
+        std::size_t objectsFreed = 0;
+        std::size_t bytesAllocated = 0;
+        std::size_t bytesFreed = 0;
+        std::size_t liveObjects = 0;
+        std::size_t liveBytes = 0;
+        std::size_t peakBytes = 0;
+        double pauseSeconds = 0;
+        double maxPauseSeconds = 0;
+    };
+
+    // Registers an engine's roots (globals, stacks, frames) for as long
+    // as it lives; `mark` calls Heap::mark on each of them. Declare it as
+    // the engine's last member, so it is registered only once everything
+    // it marks exists and unregistered before any of it is destroyed
+    class Roots {
+    public:
+        explicit Roots(std::function<void()> mark);
+        ~Roots();
+
+        Roots(const Roots&) = delete;
+        Roots& operator=(const Roots&) = delete;
+
+    private:
+        friend class Heap;
+        std::function<void()> markRoots;
+    };
+
+    // Keeps a temporary that only a C++ local holds alive while code
+    // that may allocate runs. Roots nest, so they are kept on a stack.
+    // A single value is only pushed if it refers to an object when the
+    // root is made; numbers, strings and the rest need no help
+    class Root {
+    public:
+        explicit Root(const Value& value);
+        explicit Root(const std::vector<Value>& values) { push(Temporary::Kind::VALUES, &values); }
+        explicit Root(const GcObject* object) { push(Temporary::Kind::OBJECT, object); }
+
+        ~Root() {
+            if (pushed) state().temporaries.pop_back();
+        }
+
+        Root(const Root&) = delete;
+        Root& operator=(const Root&) = delete;
+
+    private:
+        bool pushed = true;
+    };
+
+    template <typename T, typename... Args>
+    static T* make(Args&&... args) {
+        T* object = new T(std::forward<Args>(args)...);
+        track(object, sizeof(T));
+        return object;
+    }
+
+    static void mark(const GcObject* object) {
+        if (object == nullptr || object->marked) return;
+
+        object->marked = true;
+        state().gray.push_back(object);
+    }
+
+    static void mark(const Value& value);
+
+    static void collect();
+
+    // Collect before every allocation, to flush out missing roots
+    static void setStress(bool enabled);
+    static const Stats& stats();
+
+private:
+    static constexpr std::size_t MIN_THRESHOLD = 256 * 1024;
+    static constexpr std::size_t GROWTH_FACTOR = 2;
+
+    struct Temporary {
+        enum class Kind : std::uint8_t { VALUE, VALUES, OBJECT };
+
+        Kind kind;
+        const void* pointer;
+    };
+
+    struct State {
+        GcObject* objects = nullptr;
+        std::size_t threshold = MIN_THRESHOLD;
+        bool stress = false;
+        bool collecting = false;
+
+        std::vector<Roots*> roots;
+        std::vector<Temporary> temporaries;
+        // Marked but not yet traced
+        std::vector<const GcObject*> gray;
+
+        Stats stats;
+
+        ~State();
+    };
+
+    // Function-local so the global engines can allocate from their
+    // constructors during static initialization
+    static State& state();
+
+    static void push(Temporary::Kind kind, const void* pointer) {
+        state().temporaries.push_back({kind, pointer});
+    }
+
+    // Link a new object in; may collect, keeping `object` alive
+    static void track(GcObject* object, std::size_t size);
+
+    static void markRoots();
+    static void traceReferences();
+    static void sweep();
+};
+
+inline Heap::Root::Root(const Value& value) {
+    pushed = value.isCallable() || value.isInstance();
+    if (pushed) push(Temporary::Kind::VALUE, &value);
+}
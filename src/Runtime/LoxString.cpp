@@ -0,0 +1,179 @@
+#include "LoxString.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+// Concatenations up to this long are copied into a flat string; longer
+// ones become rope nodes. Appending short pieces to a rope merges them
+// into its last leaf until the leaf reaches this size.
+static constexpr std::size_t MAX_FLAT_CONCAT = 256;
+
+StringRef LoxString::create(std::string_view text) {
+    LoxString* string = allocate(text.size());
+    std::memcpy(string->inlineChars(), text.data(), text.size());
+
+    return StringRef(string);
+}
+
+StringRef LoxString::concat(const LoxString& a, const LoxString& b) {
+    if (b.length == 0) return StringRef(&a);
+    if (a.length == 0) return StringRef(&b);
+
+    return StringRef(join(&a, &b));
+}
+
+StringRef LoxString::intern(std::string_view text) {
+    // Keys view the interned strings' own characters. The table keeps a
+    // reference to each, so they are never freed
+    static std::unordered_map<std::string_view, StringRef> table;
+
+    auto it = table.find(text);
+    if (it != table.end()) return it->second;
+
+    StringRef string = create(text);
+    const_cast<LoxString*>(string.get())->interned = true;
+    table.emplace(string->view(), string);
+
+    return string;
+}
+
+bool LoxString::equals(const LoxString& a, const LoxString& b) {
+    if (&a == &b) return true;
+    if (a.interned && b.interned) return false;
+    if (a.length != b.length) return false;
+    // Only use hashes that are already known; computing one costs as
+    // much as comparing the characters
+    if (a.hashed && b.hashed && a.hash != b.hash) return false;
+
+    return a.view() == b.view();
+}
+
+LoxString* LoxString::allocate(std::size_t length) {
+    void* memory = ::operator new(sizeof(LoxString) + length);
+    LoxString* string = new (memory) LoxString(length);
+    string->data = string->inlineChars();
+
+    return string;
+}
+
+const LoxString* LoxString::node(const LoxString* left, const LoxString* right) {
+    void* memory = ::operator new(sizeof(LoxString) + sizeof(Children));
+    LoxString* string = new (memory) LoxString(left->length + right->length);
+    string->rope = true;
+    string->depth = std::max(left->depth, right->depth) + 1;
+
+    left->retain();
+    right->retain();
+    string->children() = {left, right};
+
+    return string;
+}
+
+// AVL-style join: hang the shorter tree off the taller one's spine at a
+// point where the heights match, then rotate on the way back up if that
+// made a subtree two levels taller than its sibling. Intermediate nodes
+// are held by StringRef so the ones a rotation discards are freed.
+const LoxString* LoxString::join(const LoxString* left, const LoxString* right) {
+    if (left->length + right->length <= MAX_FLAT_CONCAT)
+        return flatConcat(*left, *right);
+
+    if (left->depth > right->depth + 1) {
+        const Children& outer = left->children();
+        StringRef joined(join(outer.right, right));
+
+        if (joined->depth <= outer.left->depth + 1)
+            return node(outer.left, joined.get());
+
+        const Children& inner = joined->children();
+
+        if (inner.left->depth <= inner.right->depth)
+            return node(StringRef(node(outer.left, inner.left)).get(), inner.right);
+
+        const Children& middle = inner.left->children();
+        return node(StringRef(node(outer.left, middle.left)).get(),
+                    StringRef(node(middle.right, inner.right)).get());
+    }
+
+    if (right->depth > left->depth + 1) {
+        const Children& outer = right->children();
+        StringRef joined(join(left, outer.left));
+
+        if (joined->depth <= outer.right->depth + 1)
+            return node(joined.get(), outer.right);
+
+        const Children& inner = joined->children();
+
+        if (inner.right->depth <= inner.left->depth)
+            return node(inner.left, StringRef(node(inner.right, outer.right)).get());
+
+        const Children& middle = inner.right->children();
+        return node(StringRef(node(inner.left, middle.left)).get(),
+                    StringRef(node(middle.right, outer.right)).get());
+    }
+
+    return node(left, right);
+}
+
+const LoxString* LoxString::flatConcat(const LoxString& a, const LoxString& b) {
+    LoxString* string = allocate(a.length + b.length);
+    a.copyTo(string->inlineChars());
+    b.copyTo(string->inlineChars() + a.length);
+
+    return string;
+}
+
+// Copy the rope's leaves into one buffer and drop the halves; the node
+// is a plain string from then on. Ancestors keep their recorded depth,
+// which only ever overestimates.
+void LoxString::flatten() const {
+    char* buffer = new char[length];
+    copyTo(buffer);
+
+    Children& halves = children();
+    halves.left->release();
+    halves.right->release();
+    halves = {nullptr, nullptr};
+
+    data = buffer;
+    depth = 0;
+}
+
+void LoxString::copyTo(char* out) const {
+    if (data) {
+        std::memcpy(out, data, length);
+        return;
+    }
+
+    const Children& halves = children();
+    halves.left->copyTo(out);
+    halves.right->copyTo(out + halves.left->length);
+}
+
+void LoxString::destroy(const LoxString* string) {
+    if (string->rope) {
+        if (string->data) {
+            delete[] string->data;
+        } else {
+            string->children().left->release();
+            string->children().right->release();
+        }
+    }
+
+    string->~LoxString();
+    ::operator delete(const_cast<LoxString*>(string));
+}
+
+// FNV-1a
+std::size_t LoxString::hashOf(std::string_view text) {
+    std::uint32_t hash = 2166136261u;
+
+    for (char c : text) {
+        hash ^= static_cast<std::uint8_t>(c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
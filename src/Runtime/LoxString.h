@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Ref.h"
+
+class LoxString;
+
+// Owning handle to a LoxString; copies share the string
+using StringRef = Ref<const LoxString>;
+
+// Immutable Lox string. The characters live right after the header in
+// one allocation. The length is known up front and the hash is computed
+// the first time it is needed, then cached. Strings are reference
+// counted (non-atomically; the interpreter is single threaded) and
+// handed around as StringRef, so copying a string value never copies
+// characters.
+//
+// Literals are interned: there is exactly one interned string per
+// content, so two interned strings are equal exactly when they are the
+// same object. Strings built at run time (concatenation) are not, and
+// compare by length, hash and then characters.
+//
+// Concatenating long strings builds a rope: a node that points at its
+// two halves instead of copying them. Ropes are kept height balanced
+// as they grow, so appending to a string in a loop costs O(log n) per
+// piece rather than a copy of everything so far. A rope is flattened
+// into one buffer the first time its characters are needed (printing,
+// comparing, hashing), after which it behaves like any other string.
+class LoxString {
+public:
+    // A new string holding a copy of `text`
+    static StringRef create(std::string_view text);
+    static StringRef concat(const LoxString& a, const LoxString& b);
+    // The interned string for `text`; it lives for the rest of the run
+    static StringRef intern(std::string_view text);
+
+    static bool equals(const LoxString& a, const LoxString& b);
+
+    std::string_view view() const {
+        if (!data) flatten();
+        return {data, length};
+    }
+
+    std::size_t size() const { return length; }
+
+    std::size_t hashCode() const {
+        if (!hashed) {
+            hash = hashOf(view());
+            hashed = true;
+        }
+        return hash;
+    }
+
+    bool isInterned() const { return interned; }
+
+    void retain() const { refCount++; }
+    void release() const {
+        if (--refCount == 0) destroy(this);
+    }
+
+private:
+    // Halves of a rope, stored after the header; null once flattened
+    struct Children {
+        const LoxString* left;
+        const LoxString* right;
+    };
+
+    mutable std::uint32_t refCount = 0;
+    bool interned = false;
+    bool rope = false;
+    mutable bool hashed = false;
+    // Rope height; 0 for flat strings and flattened ropes
+    mutable std::uint8_t depth = 0;
+    std::size_t length;
+    mutable std::size_t hash = 0;
+    // The characters: inline for flat strings, a separate buffer for a
+    // flattened rope and null for a rope not yet flattened
+    mutable const char* data = nullptr;
+
+    explicit LoxString(std::size_t length) : length(length) {}
+
+    char* inlineChars() { return reinterpret_cast<char*>(this + 1); }
+    Children& children() const {
+        return *reinterpret_cast<Children*>(const_cast<LoxString*>(this) + 1);
+    }
+
+    // Header plus room for `length` characters
+    static LoxString* allocate(std::size_t length);
+    // Rope node over `left` and `right`, sharing both
+    static const LoxString* node(const LoxString* left, const LoxString* right);
+    // Balanced concatenation of two strings; the result is unowned
+    static const LoxString* join(const LoxString* left, const LoxString* right);
+    static const LoxString* flatConcat(const LoxString& a, const LoxString& b);
+
+    void flatten() const;
+    void copyTo(char* out) const;
+
+    static void destroy(const LoxString* string);
+    static std::size_t hashOf(std::string_view text);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Owning handle to an intrusively reference-counted object: anything
+// with retain() and release(). The count lives in the object itself
+// and is a plain integer (the interpreter is single threaded), so a
+// handle is one pointer, creating the object is one allocation and
+// copying a handle is an increment.
+//
+// Used for what the collector does not manage because it cannot form
+// cycles: strings and compiled code.
+template <typename T>
+class Ref {
+public:
+    Ref() = default;
+
+    explicit Ref(T* object) : object(object) {
+        if (object) object->retain();
+    }
+
+    Ref(const Ref& other) : Ref(other.object) {}
+    Ref(Ref&& other) noexcept : object(std::exchange(other.object, nullptr)) {}
+
+    // Ref<Derived> to Ref<Base>, Ref<T> to Ref<const T>
+    template <typename U>
+        requires std::is_convertible_v<U*, T*>
+    Ref(const Ref<U>& other) : Ref(other.get()) {}
+
+    Ref& operator=(Ref other) noexcept {
+        std::swap(object, other.object);
+        return *this;
+    }
+
+    ~Ref() {
+        if (object) object->release();
+    }
+
+    template <typename... Args>
+    static Ref make(Args&&... args) {
+        return Ref(new std::remove_const_t<T>(std::forward<Args>(args)...));
+    }
+
+    T* get() const { return object; }
+    T& operator*() const { return *object; }
+    T* operator->() const { return object; }
+    explicit operator bool() const { return object != nullptr; }
+
+private:
+    T* object = nullptr;
+};
+
+// Count for a type handed around by Ref and freed with delete when the
+// last handle goes. Derived is the most derived type, so no virtual
+// destructor is needed
+template <typename Derived>
+class RefCounted {
+public:
+    void retain() const { refCount++; }
+
+    void release() const {
+        if (--refCount == 0) delete static_cast<const Derived*>(this);
+    }
+
+protected:
+    RefCounted() = default;
+    // A copy is a new object nobody holds yet
+    RefCounted(const RefCounted&) {}
+    RefCounted& operator=(const RefCounted&) { return *this; }
+    ~RefCounted() = default;
+
+private:
+    mutable std::uint32_t refCount = 0;
+};
@@ -3,17 +3,28 @@
 #include "../Parser/Parser.h"
 #include "../Semantic/Resolver.h"
 #include "../AstPrinter/AstPrinter.h"
+#include "FlatAst.h"
+#include "Heap.h"
+#include "../VM/Compiler.h"
 
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <vector>
-#include <sstream>
 #include <string>
-#include <fstream>
 
 bool Runtime::s_hadError = false;
 bool Runtime::s_hadRuntimeError = false;
+Runtime::Options Runtime::s_options;
 Interpreter Runtime::s_interpreter;
+VM Runtime::s_vm;
+ClosureEngine Runtime::s_closureEngine;
+std::vector<std::unique_ptr<CompilationUnit>> Runtime::s_units;
+
+void Runtime::configure(const Options& options){
+    s_options = options;
+    Heap::setStress(options.gcStress);
+}
 
 int Runtime::launchREPL(){
     while(true){
@@ -23,29 +34,28 @@ int Runtime::launchREPL(){
         // Take Input
         if(!getline(std::cin, line)) break;
         // Run Command
-        Runtime::execute(line);
+        Runtime::execute(SourceBuffer::fromString(std::move(line)));
 
         // New line = New start
         s_hadError=false;
     }
 
+    printGcStats();
     return 0;
 }
 
 int Runtime::processFile(const std::string& path){
-    // File input stream
-    std::ifstream file(path);
+    // Map the file (or read it, for pipes and stdin)
+    std::unique_ptr<SourceBuffer> source = SourceBuffer::fromFile(path);
 
     // Handle file read failure
-    if(!file.is_open()){
+    if(!source){
         std::cerr << "Could not open file: " << path << std::endl;
         return 74; // I/O error (can't open file)
     }
 
-    // Read entire file into buffer
-    std::stringstream buffer;
-    buffer << file.rdbuf(); 
-    Runtime::execute(buffer.str());
+    Runtime::execute(std::move(source));
+    printGcStats();
     
     if(s_hadError) 
         return 65; // Data format error (syntax/parse error)
@@ -56,19 +66,30 @@ int Runtime::processFile(const std::string& path){
     return 0; 
 }
 
-void Runtime::execute(const std::string& source){
+void Runtime::execute(std::unique_ptr<SourceBuffer> source){
+    s_units.push_back(std::make_unique<CompilationUnit>(std::move(source)));
+    CompilationUnit& unit = *s_units.back();
+
     // Initialize the scanner
-    Lexer lexer(source);
+    Lexer lexer(unit.text());
 
-    std::vector<Token> tokens = lexer.scanTokens();
-    // Print all the tokens
-    for(const Token& token: tokens){
-        std::cout << token << std::endl;
+    if(s_options.dumpTokens){
+        std::vector<Token> tokens = lexer.scanTokens();
+        // Print all the tokens
+        for(const Token& token: tokens){
+            std::cout << token << std::endl;
+        }
+
+        Parser parser(std::move(tokens), unit);
+        unit.statements = parser.parse();
     }
-    
-    // Initialize the parser
-    Parser parser(tokens);
-    std::vector<std::unique_ptr<Stmt>> statements = parser.parse();
+    else{
+        // Stream tokens straight from the lexer into the parser
+        Parser parser(lexer, unit);
+        unit.statements = parser.parse();
+    }
+
+    std::span<Stmt* const> statements = unit.statements;
     if (statements.empty()) {
         std::cerr << "Parser returned nullptr!" << std::endl;
         return;
@@ -77,18 +98,67 @@ void Runtime::execute(const std::string& source){
     // Stop if there was a syntax error.
     if(s_hadError) return;
 
-    AstPrinter printer;
-    printer.print(statements);
+    if(s_options.dumpAst){
+        AstPrinter printer;
+        printer.print(statements);
+    }
 
-    Resolver resolver(s_interpreter);
+    // The bytecode compiler reads the flat encoding too
+    bool compileBytecode = s_options.engine == Engine::VM || s_options.dumpBytecode;
+    FlatAst flat;
+    if(s_options.dumpFlatAst || compileBytecode){
+        flat = FlatAst::build(statements, unit.text());
+        if(s_hadError) return;
+    }
+
+    if(s_options.dumpFlatAst){
+        flat.print();
+        std::cout << "; " << flat.size() << " nodes, " << flat.bytes()
+                  << " bytes flat, " << unit.arena.bytesUsed() << " bytes as a tree\n";
+    }
+
+    Resolver resolver(unit.arena);
     resolver.resolve(statements);
 
     if(s_hadError) return;
 
+    if(compileBytecode){
+        Ref<Prototype> script = Compiler::compile(flat);
+        if(s_hadError) return;
+
+        if(s_options.dumpBytecode){
+            script->chunk.disassemble("<script>");
+        }
+
+        if(s_options.engine == Engine::VM){
+            s_vm.interpret(std::move(script));
+            return;
+        }
+    }
+
+    if(s_options.engine == Engine::CLOSURE){
+        s_closureEngine.interpret(statements);
+        return;
+    }
+
     // Interpret
     s_interpreter.interpret(statements);
 }
 
+void Runtime::printGcStats() {
+    if(!s_options.gcStats) return;
+
+    const Heap::Stats& stats = Heap::stats();
+    std::fprintf(stderr,
+                 "[gc] %zu collections, %.3f ms paused (max %.3f ms)\n"
+                 "[gc] %zu objects allocated (%zu bytes), %zu freed (%zu bytes)\n"
+                 "[gc] %zu objects live (%zu bytes), peak %zu bytes\n",
+                 stats.collections, stats.pauseSeconds * 1e3, stats.maxPauseSeconds * 1e3,
+                 stats.objectsAllocated, stats.bytesAllocated,
+                 stats.objectsFreed, stats.bytesFreed,
+                 stats.liveObjects, stats.liveBytes, stats.peakBytes);
+}
+
 void Runtime::error(int line, std::string message) {
     report(line, "", message);
 }
@@ -98,7 +168,7 @@ void Runtime::error(const Token& token, std::string message){
         Runtime::report(token.line, " at end", message);
     }
     else {
-        Runtime::report(token.line, " at '" + token.lexeme + "'", message);
+        Runtime::report(token.line, " at '" + std::string(token.lexeme) + "'", message);
     }
 }
 
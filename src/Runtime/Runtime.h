@@ -1,12 +1,39 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <vector>
+#include "CompilationUnit.h"
 #include "../Token/Token.h"
 #include "../Interpreter/RuntimeError.h"
 #include "../Interpreter/Interpreter.h"
+#include "../VM/VM.h"
+#include "../ClosureCompiler/ClosureCompiler.h"
 
 class Runtime{
 public:
+    enum class Engine {
+        TREE,   // Walk the AST (Interpreter)
+        VM,     // Compile to bytecode and run it (VM)
+        CLOSURE // Compile to C++ closures and run those (ClosureEngine)
+    };
+
+    struct Options {
+        Engine engine = Engine::TREE;
+
+        // Debug output
+        bool dumpTokens = false;
+        bool dumpAst = false;
+        bool dumpFlatAst = false;
+        bool dumpBytecode = false;
+
+        // Collector
+        bool gcStress = false;   // Collect on every allocation
+        bool gcStats = false;    // Print heap statistics on exit
+    };
+
+    static void configure(const Options& options);
+
     // Entry point
     static int processFile(const std::string& path);
     static int launchREPL();
@@ -20,9 +47,15 @@ private:
     // State
     static bool s_hadError;
     static bool s_hadRuntimeError;
+    static Options s_options;
     static Interpreter s_interpreter;
+    static VM s_vm;
+    static ClosureEngine s_closureEngine;
+    // Every unit run so far; the interpreter may still reference them
+    static std::vector<std::unique_ptr<CompilationUnit>> s_units;
 
     // Internal execution
-    static void execute(const std::string& source);
+    static void execute(std::unique_ptr<SourceBuffer> source);
+    static void printGcStats();
     static void report(int line, const std::string where, const std::string message); 
 };
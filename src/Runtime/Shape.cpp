@@ -0,0 +1,27 @@
+#include "Shape.h"
+
+#include <algorithm>
+
+const Shape* Shape::empty() {
+    static const Shape root;
+    return &root;
+}
+
+int Shape::slotOf(int symbol) const {
+    // Instances rarely have more than a handful of fields, where a scan
+    // beats hashing
+    auto it = std::find(symbols.begin(), symbols.end(), symbol);
+    return it == symbols.end() ? -1 : static_cast<int>(it - symbols.begin());
+}
+
+const Shape* Shape::adding(int symbol) const {
+    std::unique_ptr<Shape>& next = transitions[symbol];
+
+    if (!next) {
+        next.reset(new Shape());
+        next->symbols = symbols;
+        next->symbols.push_back(symbol);
+    }
+
+    return next.get();
+}
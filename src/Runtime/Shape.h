@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class LoxCallable;
+
+// Hidden class of an instance: which fields it has and the slot each
+// one lives in. Instances that gained the same fields in the same order
+// share one Shape, so an instance stores only its field values, in a
+// compact array, and a property access can be cached per call site as
+// "this shape -> this slot".
+//
+// Shapes form a tree rooted at the empty shape; adding a field follows
+// (or creates) the transition for that name. They are never freed: a
+// program has only as many as the field orders its code produces.
+class Shape {
+public:
+    // The shape of an instance with no fields
+    static const Shape* empty();
+
+    // Slot of the field named `symbol`, or -1
+    int slotOf(int symbol) const;
+
+    // The shape after adding field `symbol`, which goes in slot size()
+    const Shape* adding(int symbol) const;
+
+    int size() const { return static_cast<int>(symbols.size()); }
+
+private:
+    Shape() = default;
+
+    // SymbolTable id of the field in each slot
+    std::vector<int> symbols;
+    mutable std::unordered_map<int, std::unique_ptr<Shape>> transitions;
+};
+
+// Inline cache for one property access site (a Get or Set node, or a
+// VM instruction). Remembers the last few shapes seen there with the
+// slot they resolved to; for a store that adds a field, also the shape
+// the instance moves to. Sites that see more shapes than it holds keep
+// evicting the oldest entry.
+struct PropertyCache {
+    static constexpr int ENTRIES = 4;
+
+    struct Entry {
+        const Shape* shape = nullptr;
+        // Same as `shape` unless the access adds the field
+        const Shape* next = nullptr;
+        int slot = -1;
+    };
+
+    Entry entries[ENTRIES];
+    std::uint8_t victim = 0;
+
+    const Entry* find(const Shape* shape) const {
+        for (const Entry& entry : entries) {
+            if (entry.shape == shape) return &entry;
+        }
+        return nullptr;
+    }
+
+    void add(const Shape* shape, const Shape* next, int slot) {
+        entries[victim] = {shape, next, slot};
+        victim = (victim + 1) % ENTRIES;
+    }
+};
+
+// Inline cache for one method call site, `obj.name(...)`. Keyed by the
+// receiver's class (by its id, as addresses of collected classes get
+// reused) and shape, which proves no field shadows the method. A
+// `super.name` site has no instance to look at and passes a null shape.
+struct MethodCache {
+    static constexpr int ENTRIES = 4;
+
+    struct Entry {
+        std::uint64_t classId = 0;
+        const Shape* shape = nullptr;
+        LoxCallable* method = nullptr;
+    };
+
+    Entry entries[ENTRIES];
+    std::uint8_t victim = 0;
+
+    LoxCallable* find(std::uint64_t classId, const Shape* shape) const {
+        for (const Entry& entry : entries) {
+            if (entry.classId == classId && entry.shape == shape) return entry.method;
+        }
+        return nullptr;
+    }
+
+    void add(std::uint64_t classId, const Shape* shape, LoxCallable* method) {
+        entries[victim] = {classId, shape, method};
+        victim = (victim + 1) % ENTRIES;
+    }
+};
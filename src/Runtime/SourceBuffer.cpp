@@ -0,0 +1,79 @@
+#include "SourceBuffer.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<SourceBuffer> SourceBuffer::fromFile(const std::string& path) {
+    std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+
+    if (path == "-") {
+        if (!buffer->readAll(STDIN_FILENO)) return nullptr;
+        return buffer;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    // mmap can't map zero bytes, and pipes/devices have no size to map
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+            ::close(fd);
+
+            buffer->data = static_cast<const char*>(addr);
+            buffer->size = st.st_size;
+            buffer->mapped = true;
+            return buffer;
+        }
+    }
+
+    bool ok = buffer->readAll(fd);
+    ::close(fd);
+
+    if (!ok) return nullptr;
+    return buffer;
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::fromString(std::string text) {
+    std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+    buffer->owned = std::move(text);
+    buffer->data = buffer->owned.data();
+    buffer->size = buffer->owned.size();
+    return buffer;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped)
+        ::munmap(const_cast<char*>(data), size);
+}
+
+bool SourceBuffer::readAll(int fd) {
+    char chunk[64 * 1024];
+
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        owned.append(chunk, n);
+    }
+
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Read-only script text. Regular files are memory-mapped and scanned
+// in place, so only the pages the lexer touches are ever read; pipes,
+// stdin and REPL lines fall back to an owned buffer.
+class SourceBuffer {
+public:
+    // Returns nullptr if the file can't be opened or read.
+    // "-" reads standard input.
+    static std::unique_ptr<SourceBuffer> fromFile(const std::string& path);
+    static std::unique_ptr<SourceBuffer> fromString(std::string text);
+
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    std::string_view text() const { return {data, size}; }
+    bool isMapped() const { return mapped; }
+
+private:
+    SourceBuffer() = default;
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool mapped = false;
+    std::string owned;
+
+    // read() until EOF, for anything that can't be mapped
+    bool readAll(int fd);
+};
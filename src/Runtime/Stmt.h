@@ -1,15 +1,13 @@
 #pragma once
 
-#include "../Token/Token.h"
 #include "../Token/Token.h"
 #include "../Runtime/Value.h"
 #include "../Runtime/Expr.h"
+#include "../Runtime/Binding.h"
 
-#include <utility>
 #include <variant>
-#include <memory>
+#include <span>
 #include <string>
-#include <vector>
 
 class Stmt {
 public:
@@ -39,17 +37,20 @@ public:
         virtual ~Visitor() = default;
     };
 
-    virtual ~Stmt() = default;
     virtual Value accept(Visitor& visitor) const = 0;
+
+protected:
+    // Arena-owned like Expr, see there
+    ~Stmt() = default;
 };
 
 // Nested Class
 class Stmt::Expression : public Stmt {
     public:
-        Expression(std::unique_ptr<Expr> expression)
-            : expression(std::move(expression)) {}
+        Expression(Expr* expression)
+            : expression(expression) {}
 
-        std::unique_ptr<Expr> expression;
+        Expr* expression;
 
         Value accept(Visitor& visitor) const override {
             return visitor.visitExpressionStmt(*this);
@@ -58,10 +59,10 @@ class Stmt::Expression : public Stmt {
 
 class Stmt::Print : public Stmt {
 public:
-    Print(std::unique_ptr<Expr> expression)
-        : expression(std::move(expression)) {}
+    Print(Expr* expression)
+        : expression(expression) {}
 
-    std::unique_ptr<Expr> expression;
+    Expr* expression;
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitPrintStmt(*this);
@@ -70,11 +71,13 @@ public:
 
 class Stmt::Var : public Stmt {
 public:
-    Var(Token name, std::unique_ptr<Expr> initializer)
-        : name(name), initializer(std::move(initializer)) {}
+    Var(Token name, Expr* initializer)
+        : name(name), initializer(initializer) {}
 
     Token name;
-    std::unique_ptr<Expr> initializer;
+    Expr* initializer;
+    // Set by the Resolver
+    mutable Binding binding;
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitVarStmt(*this);
@@ -83,10 +86,16 @@ public:
 
 class Stmt::Block : public Stmt {
 public:
-    Block(std::vector<std::unique_ptr<Stmt>> statements)
-        : statements(std::move(statements)) {}
+    Block(std::span<Stmt* const> statements)
+        : statements(statements) {}
 
-    std::vector<std::unique_ptr<Stmt>> statements;
+    std::span<Stmt* const> statements;
+    // Frame slots and cells of the variables declared directly in the
+    // block, set by the Resolver; a block that declares nothing has none
+    mutable int firstSlot = 0;
+    mutable int slotCount = 0;
+    mutable int firstCell = 0;
+    mutable int cellCount = 0;
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitBlockStmt(*this);
@@ -95,16 +104,16 @@ public:
 
 class Stmt::If : public Stmt {
 public:
-    If(std::unique_ptr<Expr> condition,
-          std::unique_ptr<Stmt> thenBranch,
-          std::unique_ptr<Stmt> elseBranch)
-        : condition(std::move(condition)),
-        thenBranch(std::move(thenBranch)),
-        elseBranch(std::move(elseBranch)) {}
+    If(Expr* condition,
+          Stmt* thenBranch,
+          Stmt* elseBranch)
+        : condition(condition),
+        thenBranch(thenBranch),
+        elseBranch(elseBranch) {}
 
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> thenBranch;
-    std::unique_ptr<Stmt> elseBranch;
+    Expr* condition;
+    Stmt* thenBranch;
+    Stmt* elseBranch;
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitIfStmt(*this);
@@ -113,13 +122,13 @@ public:
 
 class Stmt::While : public Stmt {
 public:
-    While(std::unique_ptr<Expr> condition,
-          std::unique_ptr<Stmt> body)
-        : condition(std::move(condition)),
-        body(std::move(body)) {}
+    While(Expr* condition,
+          Stmt* body)
+        : condition(condition),
+        body(body) {}
 
-    std::unique_ptr<Expr> condition;
-    std::unique_ptr<Stmt> body;
+    Expr* condition;
+    Stmt* body;
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitWhileStmt(*this);
@@ -129,13 +138,25 @@ public:
 class Stmt::Function : public Stmt {
 public:
     Token name;
-    std::vector<Token> params;
-    std::vector<std::unique_ptr<Stmt>> body;
+    std::span<const Token> params;
+    std::span<Stmt* const> body;
+    // Set by the Resolver: where the name and each parameter live, what
+    // a closure copies out of the declaring frame (by value, or the cell
+    // for UPVALUE_CELL/CELL sources) and how big a call's frame is
+    mutable Binding binding;
+    mutable std::span<const Binding> paramBindings;
+    mutable std::span<const Binding> captures;
+    mutable int slotCount = 0;
+    mutable int cellCount = 0;
+    // Also set by the Resolver, for methods: where `this` lives, and
+    // whether this is an `init`, which always returns `this`
+    mutable Binding thisBinding;
+    mutable bool initializer = false;
 
     Function(Token name,
-             std::vector<Token> params,
-             std::vector<std::unique_ptr<Stmt>> body)
-      : name(name), params(std::move(params)), body(std::move(body)) {}
+             std::span<const Token> params,
+             std::span<Stmt* const> body)
+      : name(name), params(params), body(body) {}
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitFunctionStmt(*this);
@@ -145,10 +166,10 @@ public:
 class Stmt::Return : public Stmt {
 public:
     Token keyword;
-    std::unique_ptr<Expr> value;
+    Expr* value;
 
-    Return(Token keyword, std::unique_ptr<Expr> value)
-      : keyword(keyword), value(std::move(value)) {}
+    Return(Token keyword, Expr* value)
+      : keyword(keyword), value(value) {}
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitReturnStmt(*this);
@@ -158,16 +179,20 @@ public:
 class Stmt::Class : public Stmt {
 public:
     Token name;
-    std::unique_ptr<Expr> superclass;
-    std::vector<std::unique_ptr<Stmt::Function>> methods;
+    Expr::Variable* superclass;
+    std::span<Stmt::Function* const> methods;
+    // Set by the Resolver; `superBinding` is the variable the methods
+    // read `super` from, when there is a superclass
+    mutable Binding binding;
+    mutable Binding superBinding;
 
     Class(
         Token name, 
-        std::unique_ptr<Expr::Variable> superclass,
-        std::vector<std::unique_ptr<Stmt::Function>> methods)
-        : name(std::move(name)),
-        superclass(std::move(superclass)),
-        methods(std::move(methods)) {}
+        Expr::Variable* superclass,
+        std::span<Stmt::Function* const> methods)
+        : name(name),
+        superclass(superclass),
+        methods(methods) {}
 
     Value accept(Visitor& visitor) const override {
         return visitor.visitClassStmt(*this);
@@ -0,0 +1,95 @@
+#include "SymbolTable.h"
+
+#include <cstring>
+
+SymbolTable::State& SymbolTable::state() {
+    static State instance;
+    return instance;
+}
+
+// FNV-1a, a word at a time: identifiers are short, and this is on the
+// lexer's hot path
+std::uint32_t SymbolTable::hashOf(std::string_view name) {
+    std::uint64_t hash = 14695981039346656037ull;
+    const char* data = name.data();
+    std::size_t size = name.size();
+
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+        data += 8;
+        size -= 8;
+    }
+
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, data, size);
+    hash = (hash ^ tail ^ name.size()) * 1099511628211ull;
+
+    return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+}
+
+std::uint64_t SymbolTable::shortNameOf(std::string_view name) {
+    std::uint64_t packed = 0;
+    if (name.size() <= 8) std::memcpy(&packed, name.data(), name.size());
+    return packed;
+}
+
+void SymbolTable::grow(State& table, std::size_t capacity) {
+    std::vector<Slot> old = std::move(table.slots);
+    table.slots.assign(capacity, Slot{});
+    table.mask = capacity - 1;
+
+    for (const Slot& slot : old) {
+        if (slot.symbol < 0) continue;
+
+        std::size_t index = slot.hash & table.mask;
+        while (table.slots[index].symbol >= 0) index = (index + 1) & table.mask;
+        table.slots[index] = slot;
+    }
+}
+
+void SymbolTable::reserve(std::size_t count) {
+    State& table = state();
+
+    // Stay at most half full
+    std::size_t capacity = table.slots.empty() ? 64 : table.slots.size();
+    while (capacity < count * 2) capacity *= 2;
+
+    if (capacity > table.slots.size()) grow(table, capacity);
+}
+
+int SymbolTable::intern(std::string_view name) {
+    State& table = state();
+    if (table.names.size() * 2 >= table.slots.size()) reserve(table.names.size() + 1);
+
+    std::uint32_t hash = hashOf(name);
+    std::uint64_t shortName = shortNameOf(name);
+    std::size_t index = hash & table.mask;
+
+    // The probe ends either on the symbol or on the empty slot it goes in.
+    // Identifiers never contain a 0 byte, so equal short names are equal
+    // names, and a short name never matches a long one
+    while (table.slots[index].symbol >= 0) {
+        const Slot& slot = table.slots[index];
+        if (slot.hash == hash && slot.shortName == shortName &&
+            (shortName != 0 || table.names[slot.symbol] == name)) {
+            return slot.symbol;
+        }
+        index = (index + 1) & table.mask;
+    }
+
+    int symbol = static_cast<int>(table.names.size());
+    table.names.emplace_back(name);
+    table.slots[index] = Slot{shortName, hash, symbol};
+
+    return symbol;
+}
+
+std::string_view SymbolTable::name(int symbol) {
+    return state().names[symbol];
+}
+
+std::size_t SymbolTable::size() {
+    return state().names.size();
+}
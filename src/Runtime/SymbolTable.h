@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Process-wide identifier interning. The lexer interns every
+// identifier once and tokens carry the resulting dense id, so scopes,
+// environments and instance fields hash and compare plain ints, and
+// two names are equal exactly when their ids are.
+class SymbolTable {
+public:
+    static int intern(std::string_view name);
+    static std::string_view name(int symbol);
+    static std::size_t size();
+
+    // Make room for `count` symbols up front, so interning a large
+    // source does not keep regrowing the table
+    static void reserve(std::size_t count);
+
+private:
+    // Open addressing over a power-of-two array. The hash is kept in the
+    // slot, and so are names of up to 8 bytes (zero-padded; longer names
+    // store 0), so probing touches `names` only to confirm a long name
+    // and growing never rehashes a string
+    struct Slot {
+        std::uint64_t shortName = 0;
+        std::uint32_t hash = 0;
+        int symbol = -1;
+    };
+
+    struct State {
+        std::vector<Slot> slots;
+        std::size_t mask = 0;
+        // Entries never move, so views handed out stay valid
+        std::deque<std::string> names;
+    };
+
+    // Function-local so interning works during static initialization
+    // (the global Interpreter defines its natives from a constructor)
+    static State& state();
+
+    static std::uint32_t hashOf(std::string_view name);
+    static std::uint64_t shortNameOf(std::string_view name);
+    static void grow(State& table, std::size_t capacity);
+};
@@ -0,0 +1,10 @@
+#include "Value.h"
+
+#if CPPLOX_NAN_BOXING
+
+Value::Value(StringRef string) {
+    string->retain();
+    bits = box(string.get(), STRING_TAG);
+}
+
+#endif
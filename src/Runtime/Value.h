@@ -1,17 +1,164 @@
 #pragma once
 
+#include <bit>
+#include <cstdint>
 #include <memory>
-#include <variant>
 #include <string>
+#include <utility>
+#include <variant>
+
+#include "LoxString.h"
+
+#ifndef CPPLOX_NAN_BOXING
+#define CPPLOX_NAN_BOXING 0
+#endif
 
 class LoxCallable;
 class LoxInstance;
 
-using Value = std::variant<
-std::shared_ptr<LoxCallable>,
-std::shared_ptr<LoxInstance>,
-std::monostate,
-std::string,
-double, 
-bool
->;
+// A Lox value: nil, a boolean, a number, a string, a callable or an
+// instance. Code only goes through the is*/as* accessors, so the
+// representation can be chosen at build time:
+//
+//   CPPLOX_NAN_BOXING=0  a std::variant (the default)
+//   CPPLOX_NAN_BOXING=1  8 bytes: doubles as themselves, nil and the
+//                        booleans as quiet-NaN patterns, strings,
+//                        callables and instances as tagged pointers
+//
+// Either way a string is a reference to an immutable LoxString, so
+// copying one copies a pointer. Callables and instances are plain
+// pointers to objects the Heap owns and collects.
+// Default-constructed values are nil.
+#if !CPPLOX_NAN_BOXING
+
+class Value {
+public:
+    Value() = default;
+    Value(std::monostate) {}
+    Value(bool boolean) : storage(boolean) {}
+    Value(double number) : storage(number) {}
+    Value(StringRef string) : storage(std::move(string)) {}
+    Value(std::string_view string) : storage(LoxString::create(string)) {}
+    Value(const std::string& string) : Value(std::string_view(string)) {}
+    Value(const char* string) : Value(std::string_view(string)) {}
+    Value(LoxCallable* callable) : storage(callable) {}
+    Value(LoxInstance* instance) : storage(instance) {}
+
+    bool isNil() const { return std::holds_alternative<std::monostate>(storage); }
+    bool isBool() const { return std::holds_alternative<bool>(storage); }
+    bool isNumber() const { return std::holds_alternative<double>(storage); }
+    bool isString() const { return std::holds_alternative<StringRef>(storage); }
+    bool isCallable() const { return std::holds_alternative<LoxCallable*>(storage); }
+    bool isInstance() const { return std::holds_alternative<LoxInstance*>(storage); }
+
+    // Only valid after the matching is*() check
+    bool asBool() const { return *std::get_if<bool>(&storage); }
+    double asNumber() const { return *std::get_if<double>(&storage); }
+    const LoxString& asString() const { return **std::get_if<StringRef>(&storage); }
+    LoxCallable* asCallable() const { return *std::get_if<LoxCallable*>(&storage); }
+    LoxInstance* asInstance() const { return *std::get_if<LoxInstance*>(&storage); }
+
+private:
+    std::variant<
+        std::monostate,
+        bool,
+        double,
+        StringRef,
+        LoxCallable*,
+        LoxInstance*
+    > storage;
+};
+
+#else
+
+class Value {
+public:
+    Value() : bits(NIL_BITS) {}
+    Value(std::monostate) : bits(NIL_BITS) {}
+    Value(bool boolean) : bits(boolean ? TRUE_BITS : FALSE_BITS) {}
+    Value(double number) : bits(std::bit_cast<std::uint64_t>(number)) {}
+    Value(StringRef string);
+    Value(std::string_view string) : Value(LoxString::create(string)) {}
+    Value(const std::string& string) : Value(std::string_view(string)) {}
+    Value(const char* string) : Value(std::string_view(string)) {}
+    Value(LoxCallable* callable) : bits(box(callable, 0)) {}
+    Value(LoxInstance* instance) : bits(box(instance, INSTANCE_TAG)) {}
+
+    Value(const Value& other) : bits(other.bits) { retain(); }
+    Value(Value&& other) noexcept : bits(std::exchange(other.bits, NIL_BITS)) {}
+
+    Value& operator=(const Value& other) {
+        other.retain();
+        release();
+        bits = other.bits;
+        return *this;
+    }
+
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            release();
+            bits = std::exchange(other.bits, NIL_BITS);
+        }
+        return *this;
+    }
+
+    ~Value() { release(); }
+
+    bool isNil() const { return bits == NIL_BITS; }
+    bool isBool() const { return (bits | 1) == TRUE_BITS; }
+    bool isNumber() const { return (bits & QNAN) != QNAN; }
+    bool isString() const { return isPointer(STRING_TAG); }
+    bool isCallable() const { return isPointer(0); }
+    bool isInstance() const { return isPointer(INSTANCE_TAG); }
+
+    // Only valid after the matching is*() check
+    bool asBool() const { return bits == TRUE_BITS; }
+    double asNumber() const { return std::bit_cast<double>(bits); }
+    const LoxString& asString() const {
+        return *reinterpret_cast<const LoxString*>(bits & PAYLOAD & ~TAG_MASK);
+    }
+    LoxCallable* asCallable() const {
+        return reinterpret_cast<LoxCallable*>(bits & PAYLOAD);
+    }
+    LoxInstance* asInstance() const {
+        return reinterpret_cast<LoxInstance*>(bits & PAYLOAD & ~TAG_MASK);
+    }
+
+private:
+    // Hardware only ever produces the 0x7ff8 quiet NaN, so anything
+    // with these bits set is one of ours. The sign bit marks pointers;
+    // everything pointed to is 8-byte aligned, so the low bits say
+    // what it is: a LoxString, an instance or (untagged) a callable.
+    static constexpr std::uint64_t QNAN = 0x7ffc000000000000;
+    static constexpr std::uint64_t SIGN = 0x8000000000000000;
+    static constexpr std::uint64_t PAYLOAD = ~(QNAN | SIGN);
+    static constexpr std::uint64_t TAG_MASK = 3;
+    static constexpr std::uint64_t STRING_TAG = 1;
+    static constexpr std::uint64_t INSTANCE_TAG = 2;
+    static constexpr std::uint64_t NIL_BITS = QNAN | 1;
+    static constexpr std::uint64_t FALSE_BITS = QNAN | 2;
+    static constexpr std::uint64_t TRUE_BITS = QNAN | 3;
+
+    std::uint64_t bits;
+
+    bool isPointer(std::uint64_t tag) const {
+        return (bits & (QNAN | SIGN | TAG_MASK)) == (QNAN | SIGN | tag);
+    }
+
+    static std::uint64_t box(const void* pointer, std::uint64_t tag) {
+        return reinterpret_cast<std::uintptr_t>(pointer) | QNAN | SIGN | tag;
+    }
+
+    // Only strings are reference counted; objects belong to the Heap
+    void retain() const {
+        if (isString()) asString().retain();
+    }
+
+    void release() {
+        if (isString()) asString().release();
+    }
+};
+
+static_assert(sizeof(Value) == 8);
+
+#endif
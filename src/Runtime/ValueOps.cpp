@@ -0,0 +1,69 @@
+#include "ValueOps.h"
+
+#include "../Include/LoxCallable.h"
+#include "../Include/LoxInstance.h"
+
+#include <memory>
+
+bool ValueOps::isTruthy(const Value& value) {
+    if (value.isNil())
+        return false;
+
+    if (value.isBool())
+        return value.asBool();
+
+    return true;
+}
+
+bool ValueOps::isEqual(const Value& a, const Value& b) {
+    // Values of different types are never equal
+    if (a.isNil())
+        return b.isNil();
+
+    if (a.isBool())
+        return b.isBool() && a.asBool() == b.asBool();
+
+    if (a.isNumber())
+        return b.isNumber() && a.asNumber() == b.asNumber();
+
+    if (a.isString())
+        return b.isString() && LoxString::equals(a.asString(), b.asString());
+
+    if (a.isCallable())
+        return b.isCallable() && a.asCallable() == b.asCallable();
+
+    return b.isInstance() && a.asInstance() == b.asInstance();
+}
+
+std::string ValueOps::stringify(const Value& value) {
+    if (value.isNil())
+        return "nil";
+
+    if (value.isNumber()) {
+        std::string text = std::to_string(value.asNumber());
+
+        if (text.size() >= 2 && text.substr(text.size() - 2) == ".0") {
+            text = text.substr(0, text.size() - 2);
+        }
+
+        return text;
+    }
+
+    if (value.isBool()) {
+        return value.asBool() ? "true" : "false";
+    }
+
+    if (value.isString()) {
+        return std::string(value.asString().view());
+    }
+
+    if (value.isCallable()) {
+        return value.asCallable()->toString();
+    }
+
+    if (value.isInstance()) {
+        return value.asInstance()->toString();
+    }
+
+    return "nil";
+}
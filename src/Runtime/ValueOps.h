@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Value.h"
+
+#include <string>
+
+// Language-level operations on Values shared by every execution
+// engine, so truthiness, equality and printing cannot drift apart.
+class ValueOps {
+public:
+    // nil and false are falsey, everything else is truthy
+    static bool isTruthy(const Value& value);
+    // Same type and same value; objects compare by identity
+    static bool isEqual(const Value& a, const Value& b);
+    // Text written by `print`
+    static std::string stringify(const Value& value);
+};
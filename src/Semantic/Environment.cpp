@@ -1,52 +1,25 @@
 #include "Environment.h"
 #include "../Interpreter/RuntimeError.h"
+#include "../Runtime/SymbolTable.h"
 
-// Searches from nested to parent
-Value Environment::get(const Token& name){
-    if (values.count(name.lexeme)) {
-        return values[name.lexeme];
-    }
-
-    if (enclosing != nullptr) 
-        return enclosing->get(name);
-
-    throw new RuntimeError(name,
-                           "Undefined variable '" + name.lexeme + "'.");
-}
-
-void Environment::define(const std::string& name, const Value& value){
-    values[name] = value;
+void GlobalEnvironment::reserveSymbols() {
+    if (values.size() < SymbolTable::size())
+        values.resize(SymbolTable::size());
 }
 
-Environment* Environment::ancestor(int distance) {
-    Environment* environment = this;
+void GlobalEnvironment::define(int symbol, const Value& value){
+    if (static_cast<std::size_t>(symbol) >= values.size())
+        values.resize(symbol + 1);
 
-    for (int i=0; i<distance; i++) {
-        environment = environment->enclosing.get();
-    }
-
-    return environment;
-}
-
-Value Environment::getAt(int distance, const std::string& name) {
-    return ancestor(distance)->values[name];
+    values[symbol] = {value, true};
 }
 
-void Environment::assignAt(int distance, const Token& name, Value value) {
-   ancestor(distance)->values[name.lexeme] = value;
+void GlobalEnvironment::undefined(const Token& name) {
+    throw RuntimeError(name,
+                       "Undefined variable '" + std::string(name.lexeme) + "'.");
 }
 
-void Environment::assign(const Token& name, const Value& value) {
-    if (values.count(name.lexeme)) {
-        values[name.lexeme] = value;
-        return;
-    }
-
-    if (enclosing != nullptr) {
-        enclosing->assign(name, value);
-        return;
-    }
-    
+void GlobalEnvironment::undefinedAssign(const Token& name) {
     throw RuntimeError(name, 
-                       "Undefined variable '" + name.lexeme + "'.");
+                       "Undefined variable '" + std::string(name.lexeme) + "'.");
 }
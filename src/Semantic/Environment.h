@@ -1,26 +1,64 @@
 #pragma once
 
+#include "../Runtime/Heap.h"
 #include "../Runtime/Value.h"
 #include "../Token/Token.h"
 
+#include <cstddef>
 #include <memory>
-#include <unordered_map>
 #include <string>
+#include <vector>
 
-class Environment {
+// Box for a local that a closure captures and something assigns, so
+// the declaring frame and every closure see the same variable
+struct Cell : GcObject {
+    Value value;
+
+    explicit Cell(const Value& value) : value(value) {}
+
+    void trace() const override {
+        Heap::mark(value);
+    }
+};
+
+// Top-level variables in a table indexed by SymbolTable id. Every
+// reference token already carries its name's id, so a global access is
+// an array load; the `defined` flag keeps them late bound, and an
+// undefined name is only an error when it is actually reached.
+class GlobalEnvironment {
 public:
-    std::unordered_map<std::string, Value> values;
-    std::shared_ptr<Environment> enclosing;
+    struct Global {
+        Value value;
+        bool defined = false;
+    };
+
+    std::vector<Global> values;
+
+    // Make room for every symbol interned so far; get() and assign()
+    // rely on it
+    void reserveSymbols();
+
+    const Value& get(const Token& name) {
+        const Global& global = values[name.symbol];
+
+        if (!global.defined)
+            undefined(name);
+
+        return global.value;
+    }
+
+    void define(int symbol, const Value& value);
+
+    void assign(const Token& name, const Value& value) {
+        Global& global = values[name.symbol];
 
-    Environment() = default;
+        if (!global.defined)
+            undefinedAssign(name);
 
-    Environment(std::shared_ptr<Environment> enclosing)
-    : enclosing(enclosing) {}
+        global.value = value;
+    }
 
-    Value get(const Token& name);
-    void define(const std::string& name, const Value& value);
-    Environment* ancestor(int distance);
-    Value getAt(int distance, const std::string& name);
-    void assignAt(int distance, const Token& name, Value value);
-    void assign(const Token& name, const Value& value);
+private:
+    [[noreturn]] static void undefined(const Token& name);
+    [[noreturn]] static void undefinedAssign(const Token& name);
 };
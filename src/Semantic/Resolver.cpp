@@ -1,22 +1,85 @@
 #include "Resolver.h"
 
+#include "../Runtime/SymbolTable.h"
+
+#include <algorithm>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
 // ----------- Visitor -----------
 Value Resolver::visitBlockStmt(const Stmt::Block& stmt) {
+    if (!declaresAnything(stmt.statements)) {
+        resolveStatements(stmt.statements);
+        return std::monostate{};
+    }
+
     beginScope();
-    resolve(stmt.statements);
+    int firstSlot = function->slots;
+    int firstCell = function->cells;
+
+    resolveStatements(stmt.statements);
+
+    if (pass == Pass::BIND) {
+        stmt.firstSlot = firstSlot;
+        stmt.slotCount = scopes.back().slotCount;
+        stmt.firstCell = firstCell;
+        stmt.cellCount = scopes.back().cellCount;
+    }
     endScope();
 
     return std::monostate{};
 }
 
 Value Resolver::visitClassStmt(const Stmt::Class& stmt) {
-    declare(stmt.name);
+    ClassType enclosingClass = currentClass;
+    currentClass = ClassType::CLASS;
+
+    Binding binding = declare(stmt.name, &stmt);
     define(stmt.name);
 
+    if (pass == Pass::BIND)
+        stmt.binding = binding;
+
+    // The superclass goes in a variable of its own, in a scope around
+    // the methods, so every `super` in them is a plain variable read
+    if (stmt.superclass != nullptr) {
+        if (stmt.superclass->name.symbol == stmt.name.symbol) {
+            error(stmt.superclass->name,
+                  "A class can't inherit from itself.");
+        }
+
+        resolve(*stmt.superclass);
+        currentClass = ClassType::SUBCLASS;
+
+        Token keyword(TokenType::SUPER, "super", stmt.name.line);
+        keyword.symbol = SymbolTable::intern("super");
+
+        beginScope();
+        Binding superBinding = declare(keyword, stmt.superclass);
+        define(keyword);
+
+        if (pass == Pass::BIND)
+            stmt.superBinding = superBinding;
+    }
+
+    static const int init = SymbolTable::intern("init");
+
+    for (const Stmt::Function* method : stmt.methods) {
+        bool initializer = method->name.symbol == init;
+
+        if (pass == Pass::BIND)
+            method->initializer = initializer;
+
+        resolveFunction(*method, initializer ? FunctionType::INITIALIZER
+                                             : FunctionType::METHOD);
+    }
+
+    if (stmt.superclass != nullptr)
+        endScope();
+
+    currentClass = enclosingClass;
+
     return std::monostate{};
 }
 
@@ -27,11 +90,28 @@ Value Resolver::visitExpressionStmt(const Stmt::Expression& stmt) {
 }
 
 Value Resolver::visitFunctionStmt(const Stmt::Function& stmt) {
-    declare(stmt.name);
+    Binding binding = declare(stmt.name, &stmt);
     define(stmt.name);
 
+    if (pass == Pass::BIND)
+        stmt.binding = binding;
+
+    if (pass == Pass::BIND || binding.kind == Binding::Kind::GLOBAL) {
+        resolveFunction(stmt, FunctionType::FUNCTION);
+        return std::monostate{};
+    }
+
+    // A local function its own body refers to has to be a cell: the
+    // closure is created before the name holds it
+    bool capturedBefore = usage[&stmt].captured;
+    usage[&stmt].captured = false;
+
     resolveFunction(stmt, FunctionType::FUNCTION);
 
+    Usage& own = usage[&stmt];
+    own.capturedBySelf = own.captured;
+    own.captured = own.captured || capturedBefore;
+
     return std::monostate{};
 }
 
@@ -53,11 +133,16 @@ Value Resolver::visitPrintStmt(const Stmt::Print& stmt) {
 
 Value Resolver::visitReturnStmt(const Stmt::Return& stmt) {
     if (currentFunction == FunctionType::NONE) {
-        Runtime::error(stmt.keyword, 
-                       "Can't return from top-level");
+        error(stmt.keyword, 
+              "Can't return from top-level");
     }
 
     if (stmt.value != nullptr) {
+        if (currentFunction == FunctionType::INITIALIZER) {
+            error(stmt.keyword,
+                  "Can't return a value from an initializer.");
+        }
+
         resolve(*stmt.value);
     }
 
@@ -65,7 +150,7 @@ Value Resolver::visitReturnStmt(const Stmt::Return& stmt) {
 }
 
 Value Resolver::visitVarStmt(const Stmt::Var& stmt) {
-    declare(stmt.name);
+    Binding binding = declare(stmt.name, &stmt);
 
     if (stmt.initializer != nullptr) {
         resolve(*stmt.initializer);
@@ -73,6 +158,9 @@ Value Resolver::visitVarStmt(const Stmt::Var& stmt) {
 
     define(stmt.name);
 
+    if (pass == Pass::BIND)
+        stmt.binding = binding;
+
     return std::monostate{};
 }
 
@@ -85,7 +173,16 @@ Value Resolver::visitWhileStmt(const Stmt::While& stmt) {
 
 Value Resolver::visitAssignExpr(const Expr::Assign& expr) {
     resolve(*expr.value);
-    resolveLocal(expr, expr.name);
+
+    if (pass == Pass::ANALYZE) {
+        if (const Local* local = findLocal(expr.name.symbol))
+            usage[local->declaration].assigned = true;
+    }
+
+    Binding binding = resolveName(*function, scopes.size(), expr.name.symbol);
+
+    if (pass == Pass::BIND)
+        expr.binding = binding;
 
     return std::monostate{};
 }
@@ -119,7 +216,7 @@ Value Resolver::visitGroupingExpr(const Expr::Grouping& expr) {
     return std::monostate{};
 }
 
-Value Resolver::visitLiteralExpr(const Expr::Literal& expr) {
+Value Resolver::visitLiteralExpr(const Expr::Literal& /*expr*/) {
     return std::monostate{};
 }
 
@@ -145,23 +242,77 @@ Value Resolver::visitUnaryExpr(const Expr::Unary& expr) {
 
 Value Resolver::visitVarExpr(const Expr::Variable& expr) {
     if (!scopes.empty()) {
-        auto& scope = scopes.back();
-        auto it = scope.find(expr.name.lexeme);
-        if (it != scope.end() && it->second == false) {  
-            Runtime::error(
+        auto& scope = scopes.back().locals;
+        auto it = scope.find(expr.name.symbol);
+        if (it != scope.end() && !it->second.defined) {  
+            error(
                 expr.name,
                 "Can't read local variable in its own initializer."
             );
         }
     }
 
-    resolveLocal(expr, expr.name);
+    Binding binding = resolveName(*function, scopes.size(), expr.name.symbol);
+
+    if (pass == Pass::BIND)
+        expr.binding = binding;
+
+    return std::monostate{};
+}
+
+Value Resolver::visitThisExpr(const Expr::This& expr) {
+    if (currentClass == ClassType::NONE) {
+        error(expr.keyword,
+              "Can't use 'this' outside of a class.");
+        return std::monostate{};
+    }
+
+    Binding binding = resolveName(*function, scopes.size(), expr.keyword.symbol);
+
+    if (pass == Pass::BIND)
+        expr.binding = binding;
+
+    return std::monostate{};
+}
+
+Value Resolver::visitSuperExpr(const Expr::Super& expr) {
+    if (currentClass == ClassType::NONE) {
+        error(expr.keyword,
+              "Can't use 'super' outside of a class.");
+        return std::monostate{};
+    }
+
+    if (currentClass != ClassType::SUBCLASS) {
+        error(expr.keyword,
+              "Can't use 'super' in a class with no superclass.");
+        return std::monostate{};
+    }
+
+    static const int self = SymbolTable::intern("this");
+
+    Binding binding = resolveName(*function, scopes.size(), expr.keyword.symbol);
+    Binding receiver = resolveName(*function, scopes.size(), self);
+
+    if (pass == Pass::BIND) {
+        expr.binding = binding;
+        expr.thisBinding = receiver;
+    }
 
     return std::monostate{};
 }
 
 // ----------- Helper Functions -----------
-void Resolver::resolve(const std::vector<std::unique_ptr<Stmt>>& statements){
+void Resolver::resolve(std::span<Stmt* const> statements){
+    for (Pass next : {Pass::ANALYZE, Pass::BIND}) {
+        pass = next;
+        script = FunctionState{nullptr, 0};
+        function = &script;
+
+        resolveStatements(statements);
+    }
+}
+
+void Resolver::resolveStatements(std::span<Stmt* const> statements){
     for (auto& statement: statements) {
         resolve(*statement);
     }
@@ -176,62 +327,178 @@ void Resolver::resolve(Expr& expr){
 }
 
 void Resolver::beginScope() {
-    scopes.push_back(std::unordered_map<std::string, bool>{});
+    scopes.push_back(Scope{});
 }
 
 void Resolver::endScope() {
+    // Later blocks reuse the slots
+    function->slots -= scopes.back().slotCount;
+    function->cells -= scopes.back().cellCount;
+
     scopes.pop_back();
 }
 
-void Resolver::declare(const Token& name) {
-    if (scopes.empty()) return;
+void Resolver::error(const Token& token, const std::string& message) {
+    if (pass == Pass::ANALYZE)
+        Runtime::error(token, message);
+}
+
+Binding Resolver::declare(const Token& name, const void* declaration) {
+    if (scopes.empty()) return Binding{};
 
     auto& scope = scopes.back();
     
-    if (scope.count(name.lexeme)) {
-        Runtime::error(
+    auto it = scope.locals.find(name.symbol);
+    if (it != scope.locals.end()) {
+        error(
             name,
             "Already a variable with this name in this scope.");
+
+        return it->second.binding;
+    }
+
+    Binding binding;
+
+    if (needsCell(declaration)) {
+        binding = {Binding::Kind::CELL, function->cells++};
+        scope.cellCount++;
+        function->maxCells = std::max(function->maxCells, function->cells);
+    }
+    else {
+        binding = {Binding::Kind::LOCAL, function->slots++};
+        scope.slotCount++;
+        function->maxSlots = std::max(function->maxSlots, function->slots);
     }
 
-    scope[name.lexeme] = false;
+    scope.locals.emplace(name.symbol, Local{false, binding, declaration});
+
+    return binding;
 }
 
 void Resolver::define(const Token& name) {
     if (scopes.empty()) return;
 
     auto& scope = scopes.back();
-    scope[name.lexeme] = true;
+    scope.locals[name.symbol].defined = true;
 }
 
-void Resolver::resolveLocal(const Expr& expr, const Token& name) {
-    for (int i = scopes.size() - 1; i>=0; i--) {
-        auto& scope = scopes[i];
-        if (scope.count(name.lexeme)) {
-            interpreter.resolve(expr, scopes.size() - 1 - i);
+bool Resolver::needsCell(const void* declaration) const {
+    if (pass != Pass::BIND) return false;
+
+    auto it = usage.find(declaration);
+    if (it == usage.end()) return false;
+
+    const Usage& use = it->second;
+    return (use.captured && use.assigned) || use.capturedBySelf;
+}
+
+Binding Resolver::resolveName(
+    FunctionState& state,
+    std::size_t scopeEnd,
+    int symbol)
+{
+    for (std::size_t i = scopeEnd; i > state.scopeBase; i--) {
+        auto& locals = scopes[i - 1].locals;
+        auto it = locals.find(symbol);
+
+        if (it != locals.end()) {
+            if (pass == Pass::ANALYZE && &state != function)
+                usage[it->second.declaration].captured = true;
 
-            return;
+            return it->second.binding;
         }
     }
+
+    if (state.enclosing == nullptr) return Binding{};
+
+    Binding outer = resolveName(*state.enclosing, state.scopeBase, symbol);
+    if (outer.kind == Binding::Kind::GLOBAL) return outer;
+
+    return addCapture(state, outer);
+}
+
+Binding Resolver::addCapture(FunctionState& state, const Binding& source) {
+    bool cell = source.kind == Binding::Kind::CELL ||
+                source.kind == Binding::Kind::UPVALUE_CELL;
+    Binding::Kind kind = cell ? Binding::Kind::UPVALUE_CELL
+                              : Binding::Kind::UPVALUE;
+
+    for (std::size_t i = 0; i < state.captures.size(); i++) {
+        if (state.captures[i] == source)
+            return {kind, state.captureIndex[i]};
+    }
+
+    int index = cell ? state.cellCaptures++ : state.valueCaptures++;
+    state.captures.push_back(source);
+    state.captureIndex.push_back(index);
+
+    return {kind, index};
+}
+
+const Resolver::Local* Resolver::findLocal(int symbol) const {
+    for (std::size_t i = scopes.size(); i > 0; i--) {
+        auto& locals = scopes[i - 1].locals;
+        auto it = locals.find(symbol);
+
+        if (it != locals.end())
+            return &it->second;
+    }
+
+    return nullptr;
+}
+
+bool Resolver::declaresAnything(std::span<Stmt* const> statements) {
+    for (const Stmt* stmt : statements) {
+        if (dynamic_cast<const Stmt::Var*>(stmt) != nullptr ||
+            dynamic_cast<const Stmt::Function*>(stmt) != nullptr ||
+            dynamic_cast<const Stmt::Class*>(stmt) != nullptr)
+            return true;
+    }
+
+    return false;
 }
 
 void Resolver::resolveFunction(
-    const Stmt::Function& function,
+    const Stmt::Function& stmt,
     const FunctionType& type) 
 {
     FunctionType enclosingFunction = currentFunction;
     currentFunction = type;
 
+    FunctionState state{function, scopes.size()};
+    function = &state;
+
     beginScope();
 
-    for (const Token& param: function.params) {
-        declare(param);
+    std::vector<Binding> params;
+    for (const Token& param: stmt.params) {
+        params.push_back(declare(param, &param));
         define(param);
     }
 
-    resolve(function.body);
+    // A method's receiver is one more local after the parameters. The
+    // method itself is not a variable, so its node keys `this`'s usage
+    Binding receiver;
+    if (type == FunctionType::METHOD || type == FunctionType::INITIALIZER) {
+        Token keyword(TokenType::THIS, "this", stmt.name.line);
+        keyword.symbol = SymbolTable::intern("this");
+
+        receiver = declare(keyword, &stmt);
+        define(keyword);
+    }
+
+    resolveStatements(stmt.body);
+
+    if (pass == Pass::BIND) {
+        stmt.thisBinding = receiver;
+        stmt.paramBindings = arena.copy(params);
+        stmt.captures = arena.copy(state.captures);
+        stmt.slotCount = state.maxSlots;
+        stmt.cellCount = state.maxCells;
+    }
 
     endScope();
 
+    function = state.enclosing;
     currentFunction = enclosingFunction;
 }
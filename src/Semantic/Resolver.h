@@ -2,20 +2,40 @@
 
 #include "../Runtime/Stmt.h"
 #include "../Runtime/Expr.h"
+#include "../Runtime/Binding.h"
+#include "../Runtime/Arena.h"
 #include "../Runtime/Runtime.h"
-#include "../Interpreter/Interpreter.h"
 #include <stack>
 #include <unordered_map>
+#include <vector>
 
 enum FunctionType {
     NONE,
-    FUNCTION
+    FUNCTION,
+    METHOD,
+    INITIALIZER
 };
 
+enum class ClassType {
+    NONE,
+    CLASS,
+    SUBCLASS
+};
+
+// Reports static errors and binds every name to a Binding.
+//
+// Each function's locals are numbered into one flat frame, with slots
+// reused once a block ends. A closure copies the variables it uses out
+// of the enclosing frames when it is created; only those that are both
+// captured and assigned somewhere (or a function captured by its own
+// body) become shared cells. Knowing that takes a first pass over the
+// whole unit, so resolve() walks it twice: ANALYZE reports errors and
+// records how each declaration is used, BIND fills in the nodes.
 class Resolver : public Expr::Visitor, public Stmt::Visitor {
 public:
-    Resolver(Interpreter& interpreter)
-    : interpreter(interpreter) {}
+    // Capture lists are allocated in the unit's arena
+    explicit Resolver(Arena& arena)
+    : arena(arena) {}
 
     Value visitBlockStmt(const Stmt::Block& stmt) override;
     Value visitClassStmt(const Stmt::Class& stmt) override;
@@ -37,27 +57,89 @@ public:
     Value visitLogicalExpr(const Expr::Logical& expr) override;
     Value visitUnaryExpr(const Expr::Unary& expr) override;
     Value visitVarExpr(const Expr::Variable& expr) override;
+    Value visitThisExpr(const Expr::This& expr) override;
+    Value visitSuperExpr(const Expr::Super& expr) override;
 
-    void resolve(const std::vector<std::unique_ptr<Stmt>>& statements);
+    void resolve(std::span<Stmt* const> statements);
 
 private:
-    // Keep track of variable initialization
-    Interpreter& interpreter;
-    std::vector<std::unordered_map<std::string, bool>> scopes;
+    enum class Pass { ANALYZE, BIND };
+
+    struct Local {
+        // False until the initializer has been resolved
+        bool defined;
+        Binding binding;
+        // Declaring node (or parameter token), the key into `usage`
+        const void* declaration;
+    };
+
+    struct Scope {
+        // Keyed by SymbolTable id
+        std::unordered_map<int, Local> locals;
+        int slotCount = 0;
+        int cellCount = 0;
+    };
+
+    // Frame layout and captures of the function being resolved
+    struct FunctionState {
+        FunctionState* enclosing;
+        // First entry of `scopes` that belongs to this function
+        std::size_t scopeBase;
+        int slots = 0;
+        int maxSlots = 0;
+        int cells = 0;
+        int maxCells = 0;
+        // Where each capture comes from in the enclosing function, and
+        // the index it gets among this function's values or cells
+        std::vector<Binding> captures;
+        std::vector<int> captureIndex;
+        int valueCaptures = 0;
+        int cellCaptures = 0;
+
+        FunctionState(FunctionState* enclosing, std::size_t scopeBase)
+            : enclosing(enclosing), scopeBase(scopeBase) {}
+    };
+
+    struct Usage {
+        bool captured = false;
+        bool assigned = false;
+        bool capturedBySelf = false;
+    };
+
+    Arena& arena;
+    Pass pass = Pass::ANALYZE;
+    std::vector<Scope> scopes;
+    // The top-level script; its locals are those of top-level blocks
+    FunctionState script{nullptr, 0};
+    FunctionState* function = &script;
     FunctionType currentFunction = FunctionType::NONE;
+    ClassType currentClass = ClassType::NONE;
+    // Filled in by ANALYZE
+    std::unordered_map<const void*, Usage> usage;
 
     // Helpers
+    void resolveStatements(std::span<Stmt* const> statements);
     void resolve(Stmt& stmt);
     void resolve(Expr& expr);
 
     void beginScope();
     void endScope();
-    // Mark variable as declared but not initialized
-    void declare(const Token& name);
+    // Static errors are only reported by the ANALYZE pass
+    void error(const Token& token, const std::string& message);
+    // Mark variable as declared but not initialized and give it a slot
+    // (or a cell); global scope yields a GLOBAL binding
+    Binding declare(const Token& name, const void* declaration);
     // Mark variable as initialized
     void define(const Token& name);
-    void resolveLocal(const Expr& expr, const Token& name);
-    void resolveFunction(const Stmt::Function& function);
-    void resolveFunction(const Stmt::Function& function,
+    bool needsCell(const void* declaration) const;
+    // Where `symbol` lives as seen from `state`, whose scopes end at
+    // `scopeEnd`; captures it through each function in between
+    Binding resolveName(FunctionState& state, std::size_t scopeEnd, int symbol);
+    Binding addCapture(FunctionState& state, const Binding& source);
+    // Innermost visible local named `symbol`, in any function
+    const Local* findLocal(int symbol) const;
+    void resolveFunction(const Stmt::Function& stmt,
                          const FunctionType& type);
+    // Blocks that declare nothing share their enclosing scope
+    static bool declaresAnything(std::span<Stmt* const> statements);
 };
@@ -11,10 +11,8 @@ std::ostream& operator << (std::ostream& os, const Token& token){
 
 std::string Token::toString() const {
     std::string literalStr;
-    if(!std::holds_alternative<std::monostate>(literal)){
-        if(std::get_if<std::string>(&literal)) literalStr = std::get<std::string>(literal);
-        if(std::get_if<double>(&literal)) literalStr = std::to_string(std::get<double>(literal));
-    }
+    if(type == TokenType::STRING) literalStr = std::string(lexeme.substr(1, lexeme.size() - 2));
+    if(type == TokenType::NUMBER) literalStr = std::to_string(number);
 
-    return tokenTypeToString(type) + " " + lexeme + " " + literalStr;
+    return tokenTypeToString(type) + " " + std::string(lexeme) + " " + literalStr;
 }
@@ -5,17 +5,30 @@
 #include "../Runtime/Value.h"
 #include <ostream>
 #include <string>
-#include <any>
+#include <string_view>
 
+// A token is a view into the source buffer of the CompilationUnit
+// it was scanned from, so the unit must outlive every token (and
+// every AST node holding one).
 class Token {
 public:
     TokenType type;
-    std::string lexeme;
-    Value literal;
     int line;
+    std::string_view lexeme;
+    union {
+        // Parsed value of a NUMBER token
+        double number = 0;
+        // SymbolTable id of an IDENTIFIER token
+        int symbol;
+    };
 
-    Token(TokenType type, std::string lexeme, Value literal, int line):
-        type(type), lexeme(lexeme), literal(literal), line(line) {}
+    Token(): type(TokenType::END_OF_FILE), line(0) {}
+
+    Token(TokenType type, std::string_view lexeme, int line):
+        type(type), line(line), lexeme(lexeme) {}
+
+    Token(TokenType type, std::string_view lexeme, double number, int line):
+        type(type), line(line), lexeme(lexeme), number(number) {}
 
     std::string toString() const;
 };
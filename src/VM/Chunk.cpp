@@ -0,0 +1,132 @@
+#include "Chunk.h"
+
+#include "../Runtime/SymbolTable.h"
+#include "../Runtime/ValueOps.h"
+
+#include <cstdio>
+#include <iostream>
+
+const char* Chunk::opName(OpCode op) {
+    static const char* const names[] = {
+#define CPPLOX_OPCODE_NAME(name) #name,
+        CPPLOX_OPCODES(CPPLOX_OPCODE_NAME)
+#undef CPPLOX_OPCODE_NAME
+    };
+
+    return names[static_cast<std::uint8_t>(op)];
+}
+
+// ---------- Disassembler ----------
+void Chunk::disassemble(const std::string& name) const {
+    std::cout << "== " << name << " ==\n";
+
+    for (std::size_t offset = 0; offset < code.size();) {
+        offset = disassembleInstruction(offset);
+    }
+
+    for (const Ref<Prototype>& function : functions) {
+        std::cout << "\n";
+        function->chunk.disassemble("<fn " + function->name + ">");
+    }
+}
+
+std::size_t Chunk::disassembleInstruction(std::size_t offset) const {
+    OpCode op = static_cast<OpCode>(code[offset]);
+
+    char prefix[32];
+    if (offset > 0 && lines[offset] == lines[offset - 1])
+        std::snprintf(prefix, sizeof prefix, "%04zu    | ", offset);
+    else
+        std::snprintf(prefix, sizeof prefix, "%04zu %4d ", offset, lines[offset]);
+
+    std::cout << prefix << opName(op);
+
+    switch (op) {
+        case OpCode::CONSTANT: {
+            std::uint16_t index = readShort(offset + 1);
+            std::cout << " " << index << " '" << ValueOps::stringify(constants[index]) << "'\n";
+            return offset + 3;
+        }
+
+        case OpCode::GET_PROPERTY:
+        case OpCode::SET_PROPERTY: {
+            std::uint16_t index = readShort(offset + 1);
+            std::cout << " " << index << " '" << SymbolTable::name(names[index]) << "'"
+                      << " cache " << readShort(offset + 3) << "\n";
+            return offset + 5;
+        }
+
+        case OpCode::GET_GLOBAL:
+        case OpCode::DEFINE_GLOBAL:
+        case OpCode::SET_GLOBAL:
+        case OpCode::CHECK_FIELDS:
+        case OpCode::CLASS:
+        case OpCode::METHOD: {
+            std::uint16_t index = readShort(offset + 1);
+            std::cout << " " << index << " '" << SymbolTable::name(names[index]) << "'\n";
+            return offset + 3;
+        }
+
+        case OpCode::GET_LOCAL:
+        case OpCode::SET_LOCAL:
+        case OpCode::GET_UPVALUE:
+        case OpCode::SET_UPVALUE:
+            std::cout << " " << readShort(offset + 1) << "\n";
+            return offset + 3;
+
+        case OpCode::JUMP:
+        case OpCode::JUMP_IF_FALSE:
+        case OpCode::JUMP_IF_TRUE:
+            std::cout << " -> " << offset + 3 + readShort(offset + 1) << "\n";
+            return offset + 3;
+
+        case OpCode::LOOP:
+            std::cout << " -> " << offset + 3 - readShort(offset + 1) << "\n";
+            return offset + 3;
+
+        case OpCode::CALL:
+            std::cout << " " << static_cast<int>(code[offset + 1]) << "\n";
+            return offset + 2;
+
+        case OpCode::INVOKE: {
+            std::uint16_t index = readShort(offset + 1);
+            std::cout << " " << index << " '" << SymbolTable::name(names[index]) << "'"
+                      << " cache " << readShort(offset + 3)
+                      << " method " << readShort(offset + 5)
+                      << " (" << static_cast<int>(code[offset + 7]) << " args)\n";
+            return offset + 8;
+        }
+
+        case OpCode::GET_SUPER:
+        case OpCode::SUPER_INVOKE: {
+            std::uint16_t index = readShort(offset + 1);
+            std::cout << " " << index << " '" << SymbolTable::name(names[index]) << "'"
+                      << " method " << readShort(offset + 3);
+            if (op == OpCode::GET_SUPER) {
+                std::cout << "\n";
+                return offset + 5;
+            }
+
+            std::cout << " (" << static_cast<int>(code[offset + 5]) << " args)\n";
+            return offset + 6;
+        }
+
+        case OpCode::CLOSURE: {
+            const Prototype& function = *functions[readShort(offset + 1)];
+            std::cout << " <fn " << function.name << ">\n";
+
+            offset += 3;
+            for (int i = 0; i < function.upvalueCount; i++) {
+                bool isLocal = code[offset] != 0;
+                std::printf("%04zu    |   %s %u\n", offset,
+                            isLocal ? "local" : "upvalue", readShort(offset + 1));
+                offset += 3;
+            }
+            return offset;
+        }
+
+        default:
+            std::cout << "\n";
+            return offset + 1;
+    }
+}
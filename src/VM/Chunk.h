@@ -0,0 +1,138 @@
+#pragma once
+
+#include "../Runtime/Ref.h"
+#include "../Runtime/Shape.h"
+#include "../Runtime/Value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every instruction is a one-byte opcode followed by its operands.
+// Operands are 16-bit little-endian unless noted.
+//
+//   CONSTANT k            push constants[k]
+//   GET_LOCAL s           push slots[s]           SET_LOCAL s (keeps value)
+//   GET_UPVALUE u         push upvalue u          SET_UPVALUE u (keeps value)
+//   GET_GLOBAL n          push global names[n]    SET_GLOBAL n (keeps value)
+//   DEFINE_GLOBAL n       pop into global names[n]
+//   GET_PROPERTY n c      replace instance by field names[n], via caches[c]
+//   CHECK_FIELDS n        error unless the top is an instance
+//   SET_PROPERTY n c      [instance value] -> [value], via caches[c]
+//   JUMP o / LOOP o       move ip forward / back by o
+//   JUMP_IF_FALSE o       jump when the top is falsey, without popping
+//   JUMP_IF_TRUE o        jump when the top is truthy, without popping
+//   CALL argc (8-bit)     [callee args...] -> [result]
+//   INVOKE n c m argc     [instance args...] -> [result], calling method
+//                         names[n] via methodCaches[m]; a field of that
+//                         name is read via caches[c] and called instead
+//   CLOSURE f, then per upvalue: isLocal (8-bit), index
+//   GET_SUPER n m         [instance superclass] -> [method names[n] of
+//                         superclass bound to instance], via methodCaches[m]
+//   SUPER_INVOKE n m argc [instance args... superclass] -> [result]
+//   CLASS n               push a new class named names[n]
+//   INHERIT               [superclass class] -> [superclass], copying the
+//                         superclass's methods into the class
+//   METHOD n              [class closure] -> [class], adding the closure
+//                         as method names[n]
+#define CPPLOX_OPCODES(X) \
+    X(CONSTANT)           \
+    X(NIL)                \
+    X(TRUE)               \
+    X(FALSE)              \
+    X(POP)                \
+    X(GET_LOCAL)          \
+    X(SET_LOCAL)          \
+    X(GET_UPVALUE)        \
+    X(SET_UPVALUE)        \
+    X(GET_GLOBAL)         \
+    X(DEFINE_GLOBAL)      \
+    X(SET_GLOBAL)         \
+    X(GET_PROPERTY)       \
+    X(CHECK_FIELDS)       \
+    X(SET_PROPERTY)       \
+    X(EQUAL)              \
+    X(NOT_EQUAL)          \
+    X(GREATER)            \
+    X(GREATER_EQUAL)      \
+    X(LESS)               \
+    X(LESS_EQUAL)         \
+    X(ADD)                \
+    X(SUBTRACT)           \
+    X(MULTIPLY)           \
+    X(DIVIDE)             \
+    X(NOT)                \
+    X(NEGATE)             \
+    X(PRINT)              \
+    X(JUMP)               \
+    X(JUMP_IF_FALSE)      \
+    X(JUMP_IF_TRUE)       \
+    X(LOOP)               \
+    X(CALL)               \
+    X(INVOKE)             \
+    X(GET_SUPER)          \
+    X(SUPER_INVOKE)       \
+    X(CLOSURE)            \
+    X(CLOSE_UPVALUE)      \
+    X(RETURN)             \
+    X(CLASS)              \
+    X(INHERIT)            \
+    X(METHOD)
+
+enum class OpCode : std::uint8_t {
+#define CPPLOX_OPCODE_ENUM(name) name,
+    CPPLOX_OPCODES(CPPLOX_OPCODE_ENUM)
+#undef CPPLOX_OPCODE_ENUM
+};
+
+struct Prototype;
+
+// Bytecode of one function body
+class Chunk {
+public:
+    std::vector<std::uint8_t> code;
+    // Source line of each byte in `code`
+    std::vector<int> lines;
+
+    std::vector<Value> constants;
+    // SymbolTable ids of global variables and properties
+    std::vector<int> names;
+    // Functions declared directly in this body
+    std::vector<Ref<Prototype>> functions;
+    // One per GET_PROPERTY / SET_PROPERTY; filled in as the code runs
+    mutable std::vector<PropertyCache> caches;
+    // One per INVOKE, GET_SUPER and SUPER_INVOKE
+    mutable std::vector<MethodCache> methodCaches;
+
+    void write(std::uint8_t byte, int line) {
+        code.push_back(byte);
+        lines.push_back(line);
+    }
+
+    void writeShort(std::uint16_t value, int line) {
+        write(static_cast<std::uint8_t>(value & 0xFF), line);
+        write(static_cast<std::uint8_t>(value >> 8), line);
+    }
+
+    std::uint16_t readShort(std::size_t offset) const {
+        return static_cast<std::uint16_t>(code[offset] | (code[offset + 1] << 8));
+    }
+
+    static const char* opName(OpCode op);
+
+    // Human-readable listing of this chunk and the functions it declares
+    void disassemble(const std::string& name) const;
+    std::size_t disassembleInstruction(std::size_t offset) const;
+};
+
+// A compiled function: its code plus what a call needs to set up a frame.
+// Shared by the enclosing chunk and every closure made from it
+struct Prototype : RefCounted<Prototype> {
+    std::string name;
+    int arity = 0;
+    int upvalueCount = 0;
+    // Stack slots a call may use, including the callee and arguments
+    int maxSlots = 1;
+    Chunk chunk;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Chunk.h"
+#include "../Include/LoxCallable.h"
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class VM;
+
+// A variable captured by a closure. While the declaring frame is live
+// it points at the variable's stack slot; when the slot goes away the
+// value is moved into `closed` and `location` follows it there.
+struct Upvalue : GcObject {
+    Value* location;
+    Value closed;
+    // Next open upvalue, ordered by decreasing stack address
+    Upvalue* next = nullptr;
+
+    explicit Upvalue(Value* slot) : location(slot) {}
+
+    // While open, the VM marks the stack slot itself
+    void trace() const override {
+        Heap::mark(closed);
+    }
+};
+
+// Runtime function value of the VM: a prototype plus its captures
+class Closure : public LoxCallable {
+public:
+    Ref<Prototype> function;
+    // Null until the CLOSURE instruction has captured them
+    std::vector<Upvalue*> upvalues;
+
+    Closure(VM& vm, Ref<Prototype> function)
+        : function(std::move(function)), vm(vm) {
+        upvalues.resize(this->function->upvalueCount);
+    }
+
+    int arity() const override {
+        return function->arity;
+    }
+
+    // Only reached when native code calls back into Lox; the VM calls
+    // closures by pushing a frame instead
+    Value call(Interpreter* interpreter, std::span<const Value> arguments) override;
+    Value callMethod(Interpreter* interpreter, LoxInstance* receiver,
+                     std::span<const Value> arguments) override;
+
+    std::string toString() const override {
+        return "<fn " + function->name + ">";
+    }
+
+    void trace() const override {
+        for (const Upvalue* upvalue : upvalues) Heap::mark(upvalue);
+    }
+
+private:
+    VM& vm;
+};
@@ -0,0 +1,679 @@
+#include "Compiler.h"
+
+#include "../Runtime/Runtime.h"
+#include "../Runtime/SymbolTable.h"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr int MAX_INDEX = std::numeric_limits<std::uint16_t>::max();
+
+// Net operand stack change of each fixed-effect instruction
+static int stackEffect(OpCode op) {
+    switch (op) {
+        case OpCode::CONSTANT:
+        case OpCode::NIL:
+        case OpCode::TRUE:
+        case OpCode::FALSE:
+        case OpCode::GET_LOCAL:
+        case OpCode::GET_UPVALUE:
+        case OpCode::GET_GLOBAL:
+        case OpCode::CLOSURE:
+        case OpCode::CLASS:
+            return 1;
+
+        case OpCode::POP:
+        case OpCode::DEFINE_GLOBAL:
+        case OpCode::SET_PROPERTY:
+        case OpCode::EQUAL:
+        case OpCode::NOT_EQUAL:
+        case OpCode::GREATER:
+        case OpCode::GREATER_EQUAL:
+        case OpCode::LESS:
+        case OpCode::LESS_EQUAL:
+        case OpCode::ADD:
+        case OpCode::SUBTRACT:
+        case OpCode::MULTIPLY:
+        case OpCode::DIVIDE:
+        case OpCode::PRINT:
+        case OpCode::CLOSE_UPVALUE:
+        case OpCode::RETURN:
+        case OpCode::METHOD:
+        case OpCode::GET_SUPER:
+        case OpCode::INHERIT:
+            return -1;
+
+        // Calls are adjusted by their argument count at the call site
+        default:
+            return 0;
+    }
+}
+
+// ---------- Entry ----------
+Ref<Prototype> Compiler::compile(const FlatAst& ast) {
+    Compiler compiler(ast);
+
+    FunctionState script(nullptr, Ref<Prototype>::make());
+    script.function->name = "script";
+    // Slot 0 holds the function being run
+    script.locals.push_back({-1, 0});
+    script.stackDepth = 1;
+
+    compiler.current = &script;
+    compiler.compileBlock(ast.program);
+    compiler.emit(OpCode::NIL);
+    compiler.emit(OpCode::RETURN);
+
+    if (compiler.hadError) return {};
+    return script.function;
+}
+
+void Compiler::compile(Index node) {
+    switch (ast.kinds[node]) {
+        case Kind::BINARY:   binary(node); break;
+        case Kind::LITERAL:  literal(node); break;
+        case Kind::UNARY:    unary(node); break;
+        case Kind::LOGICAL:  logical(node); break;
+        case Kind::CALL:     call(node); break;
+        case Kind::GET:      get(node); break;
+        case Kind::SET:      set(node); break;
+        case Kind::SUPER:    super(node); break;
+
+        case Kind::GROUPING:
+            compile(ast.a[node]);
+            break;
+
+        case Kind::VARIABLE:
+        case Kind::THIS:
+            emitGet(ast.token(node));
+            break;
+
+        case Kind::ASSIGN:
+            compile(ast.a[node]);
+            emitSet(ast.token(node));
+            break;
+
+        case Kind::EXPRESSION:
+            compile(ast.a[node]);
+            emit(OpCode::POP);
+            break;
+
+        case Kind::PRINT:
+            compile(ast.a[node]);
+            emit(OpCode::PRINT);
+            break;
+
+        case Kind::BLOCK:
+            beginScope();
+            compileBlock(ast.a[node]);
+            endScope();
+            break;
+
+        case Kind::VAR:      varStatement(node); break;
+        case Kind::IF:       ifStatement(node); break;
+        case Kind::WHILE:    whileStatement(node); break;
+        case Kind::FUNCTION: functionStatement(node); break;
+        case Kind::RETURN:   returnStatement(node); break;
+        case Kind::CLASS:    classStatement(node); break;
+    }
+}
+
+void Compiler::compileBlock(Index statements) {
+    for (Index stmt : ast.list(statements)) {
+        compile(stmt);
+    }
+}
+
+// ---------- Expressions ----------
+void Compiler::binary(Index node) {
+    compile(ast.a[node]);
+    compile(ast.b[node]);
+
+    Token operator_ = ast.token(node);
+    line = operator_.line;
+    switch (operator_.type) {
+        case BANG_EQUAL:    emit(OpCode::NOT_EQUAL); break;
+        case EQUAL_EQUAL:   emit(OpCode::EQUAL); break;
+        case GREATER:       emit(OpCode::GREATER); break;
+        case GREATER_EQUAL: emit(OpCode::GREATER_EQUAL); break;
+        case LESS:          emit(OpCode::LESS); break;
+        case LESS_EQUAL:    emit(OpCode::LESS_EQUAL); break;
+        case PLUS:          emit(OpCode::ADD); break;
+        case MINUS:         emit(OpCode::SUBTRACT); break;
+        case STAR:          emit(OpCode::MULTIPLY); break;
+        case SLASH:         emit(OpCode::DIVIDE); break;
+        default: break;
+    }
+}
+
+void Compiler::literal(Index node) {
+    const Value& value = *ast.constants[ast.a[node]];
+
+    if (value.isNil()) {
+        emit(OpCode::NIL);
+    }
+    else if (value.isBool()) {
+        emit(value.asBool() ? OpCode::TRUE : OpCode::FALSE);
+    }
+    else {
+        emit(OpCode::CONSTANT, makeConstant(value));
+    }
+}
+
+void Compiler::unary(Index node) {
+    compile(ast.a[node]);
+
+    Token operator_ = ast.token(node);
+    line = operator_.line;
+    emit(operator_.type == MINUS ? OpCode::NEGATE : OpCode::NOT);
+}
+
+void Compiler::logical(Index node) {
+    compile(ast.a[node]);
+
+    // Short-circuit with the left operand as the result
+    std::size_t skip = emitJump(ast.token(node).type == OR ? OpCode::JUMP_IF_TRUE
+                                                           : OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    compile(ast.b[node]);
+    patchJump(skip);
+}
+
+void Compiler::call(Index node) {
+    Index callee = ast.a[node];
+    std::span<const Index> arguments = ast.list(ast.b[node]);
+    int paren = ast.token(node).line;
+
+    // Likewise super.name(...), on `this`; the superclass goes on top
+    if (ast.kinds[callee] == Kind::SUPER) {
+        Token keyword = ast.token(callee);
+        Token method = ast.expand(ast.tokenTable[ast.a[callee]]);
+        emitThis(keyword);
+
+        for (Index argument : arguments) {
+            compile(argument);
+        }
+
+        emitGet(keyword);
+
+        line = paren;
+        emit(OpCode::SUPER_INVOKE, makeName(method.symbol));
+        emitShort(makeMethodCache());
+        emitByte(static_cast<std::uint8_t>(arguments.size()));
+        adjustStack(-static_cast<int>(arguments.size()) - 1);
+
+        return;
+    }
+
+    // obj.name(...) calls the method without binding it to obj first
+    bool property = ast.kinds[callee] == Kind::GET;
+    compile(property ? ast.a[callee] : callee);
+
+    for (Index argument : arguments) {
+        compile(argument);
+    }
+
+    line = paren;
+    if (property) {
+        emit(OpCode::INVOKE, makeName(ast.token(callee).symbol));
+        emitShort(makeCache());
+        emitShort(makeMethodCache());
+    }
+    else {
+        emit(OpCode::CALL);
+    }
+    emitByte(static_cast<std::uint8_t>(arguments.size()));
+    adjustStack(-static_cast<int>(arguments.size()));
+}
+
+void Compiler::get(Index node) {
+    compile(ast.a[node]);
+
+    Token name = ast.token(node);
+    line = name.line;
+    emit(OpCode::GET_PROPERTY, makeName(name.symbol));
+    emitShort(makeCache());
+}
+
+void Compiler::set(Index node) {
+    compile(ast.a[node]);
+
+    // The receiver is checked before the value is evaluated
+    Token name = ast.token(node);
+    line = name.line;
+    std::uint16_t index = makeName(name.symbol);
+    emit(OpCode::CHECK_FIELDS, index);
+
+    compile(ast.b[node]);
+
+    line = name.line;
+    emit(OpCode::SET_PROPERTY, index);
+    emitShort(makeCache());
+}
+
+void Compiler::super(Index node) {
+    Token keyword = ast.token(node);
+    Token method = ast.expand(ast.tokenTable[ast.a[node]]);
+    emitThis(keyword);
+    emitGet(keyword);
+
+    line = method.line;
+    emit(OpCode::GET_SUPER, makeName(method.symbol));
+    emitShort(makeMethodCache());
+}
+
+// ---------- Statements ----------
+void Compiler::varStatement(Index node) {
+    if (ast.a[node] != FlatAst::NONE) {
+        compile(ast.a[node]);
+    }
+    else {
+        emit(OpCode::NIL);
+    }
+
+    Token name = ast.token(node);
+    line = name.line;
+    defineVariable(name);
+}
+
+void Compiler::ifStatement(Index node) {
+    std::span<const Index> branches = ast.list(ast.b[node]);
+    compile(ast.a[node]);
+
+    std::size_t thenJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    compile(branches[0]);
+
+    std::size_t elseJump = emitJump(OpCode::JUMP);
+    patchJump(thenJump);
+
+    // The condition is still on the stack along this path
+    adjustStack(1);
+    emit(OpCode::POP);
+
+    if (branches[1] != FlatAst::NONE) {
+        compile(branches[1]);
+    }
+
+    patchJump(elseJump);
+}
+
+void Compiler::whileStatement(Index node) {
+    std::size_t loopStart = chunk().code.size();
+    compile(ast.a[node]);
+
+    std::size_t exitJump = emitJump(OpCode::JUMP_IF_FALSE);
+    emit(OpCode::POP);
+    compile(ast.b[node]);
+    emitLoop(loopStart);
+
+    patchJump(exitJump);
+    adjustStack(1);
+    emit(OpCode::POP);
+}
+
+void Compiler::functionStatement(Index node) {
+    Token name = ast.token(node);
+    line = name.line;
+
+    // A local function is visible in its own body, so declare it first
+    if (current->scopeDepth > 0) {
+        declareLocal(name);
+        compileFunction(node);
+    }
+    else {
+        compileFunction(node);
+        defineVariable(name);
+    }
+}
+
+void Compiler::returnStatement(Index node) {
+    if (ast.a[node] == FlatAst::NONE) {
+        line = ast.token(node).line;
+        emitReturn();
+        return;
+    }
+
+    compile(ast.a[node]);
+
+    line = ast.token(node).line;
+    emit(OpCode::RETURN);
+}
+
+void Compiler::classStatement(Index node) {
+    Token name = ast.token(node);
+    Index superclass = ast.a[node];
+    std::span<const Index> methods = ast.list(ast.b[node]);
+
+    line = name.line;
+    emit(OpCode::CLASS, makeName(name.symbol));
+    defineVariable(name);
+
+    // The superclass stays on the stack as a local named `super` for
+    // the methods to capture
+    if (superclass != FlatAst::NONE) {
+        Token keyword(TokenType::SUPER, "super", name.line);
+        keyword.symbol = SymbolTable::intern("super");
+
+        beginScope();
+        compile(superclass);
+        declareLocal(keyword);
+
+        emitGet(name);
+        line = ast.token(superclass).line;
+        emit(OpCode::INHERIT);
+    }
+
+    // Defined first, so methods can refer to the class; then brought
+    // back to the top for METHOD to fill in
+    if (!methods.empty()) {
+        emitGet(name);
+        for (Index method : methods) {
+            compileFunction(method, true);
+
+            Token methodName = ast.token(method);
+            line = methodName.line;
+            emit(OpCode::METHOD, makeName(methodName.symbol));
+        }
+        emit(OpCode::POP);
+    }
+
+    if (superclass != FlatAst::NONE)
+        endScope();
+}
+
+void Compiler::compileFunction(Index node, bool method) {
+    static const int self = SymbolTable::intern("this");
+    static const int init = SymbolTable::intern("init");
+
+    Token name = ast.token(node);
+    std::span<const Index> params = ast.list(ast.a[node]);
+
+    FunctionState state(current, Ref<Prototype>::make());
+    Prototype& function = *state.function;
+
+    function.name = std::string(name.lexeme);
+    function.arity = static_cast<int>(params.size());
+
+    // Slot 0 is the callee (the receiver, for a method), then the
+    // parameters; the body shares their scope, as it does in the Resolver
+    state.scopeDepth = 1;
+    state.initializer = method && name.symbol == init;
+    state.locals.push_back({method ? self : -1, 0});
+    for (Index param : params) {
+        state.locals.push_back({ast.tokenTable[param].symbol, 1});
+    }
+    state.stackDepth = static_cast<int>(state.locals.size());
+    function.maxSlots = state.stackDepth;
+
+    current = &state;
+    compileBlock(ast.b[node]);
+
+    line = name.line;
+    emitReturn();
+    current = state.enclosing;
+
+    function.upvalueCount = static_cast<int>(state.upvalues.size());
+
+    std::vector<Ref<Prototype>>& functions = chunk().functions;
+    if (functions.size() > MAX_INDEX) {
+        error("Too many functions in one chunk.");
+        return;
+    }
+
+    functions.push_back(state.function);
+    emit(OpCode::CLOSURE, static_cast<std::uint16_t>(functions.size() - 1));
+
+    for (const UpvalueRef& upvalue : state.upvalues) {
+        emitByte(upvalue.isLocal ? 1 : 0);
+        emitShort(upvalue.index);
+    }
+}
+
+// ---------- Emission ----------
+void Compiler::emit(OpCode op) {
+    emitByte(static_cast<std::uint8_t>(op));
+    adjustStack(stackEffect(op));
+}
+
+void Compiler::emit(OpCode op, std::uint16_t operand) {
+    emit(op);
+    emitShort(operand);
+}
+
+void Compiler::emitByte(std::uint8_t byte) {
+    chunk().write(byte, line);
+}
+
+void Compiler::emitShort(std::uint16_t value) {
+    chunk().writeShort(value, line);
+}
+
+void Compiler::adjustStack(int delta) {
+    current->stackDepth += delta;
+
+    Prototype& function = *current->function;
+    function.maxSlots = std::max(function.maxSlots, current->stackDepth);
+}
+
+std::size_t Compiler::emitJump(OpCode op) {
+    emit(op);
+    emitShort(0xFFFF);
+    return chunk().code.size() - 2;
+}
+
+void Compiler::patchJump(std::size_t operand) {
+    std::size_t jump = chunk().code.size() - operand - 2;
+    if (jump > MAX_INDEX) {
+        error("Too much code to jump over.");
+        return;
+    }
+
+    chunk().code[operand] = static_cast<std::uint8_t>(jump & 0xFF);
+    chunk().code[operand + 1] = static_cast<std::uint8_t>(jump >> 8);
+}
+
+void Compiler::emitLoop(std::size_t loopStart) {
+    emit(OpCode::LOOP);
+
+    // Measured from the end of the operand, where ip will be
+    std::size_t offset = chunk().code.size() + 2 - loopStart;
+    if (offset > MAX_INDEX) {
+        error("Loop body too large.");
+        offset = 0;
+    }
+
+    emitShort(static_cast<std::uint16_t>(offset));
+}
+
+std::uint16_t Compiler::makeConstant(const Value& value) {
+    // Literals come from the unit's ConstantPool, so equal constants
+    // share an address
+    auto it = current->constantIndex.find(&value);
+    if (it != current->constantIndex.end()) return it->second;
+
+    std::vector<Value>& constants = chunk().constants;
+    if (constants.size() > MAX_INDEX) {
+        error("Too many constants in one chunk.");
+        return 0;
+    }
+
+    constants.push_back(value);
+    auto index = static_cast<std::uint16_t>(constants.size() - 1);
+    current->constantIndex.emplace(&value, index);
+    return index;
+}
+
+std::uint16_t Compiler::makeName(int symbol) {
+    auto it = current->nameIndex.find(symbol);
+    if (it != current->nameIndex.end()) return it->second;
+
+    std::vector<int>& names = chunk().names;
+    if (names.size() > MAX_INDEX) {
+        error("Too many names in one chunk.");
+        return 0;
+    }
+
+    names.push_back(symbol);
+    auto index = static_cast<std::uint16_t>(names.size() - 1);
+    current->nameIndex.emplace(symbol, index);
+    return index;
+}
+
+std::uint16_t Compiler::makeCache() {
+    std::vector<PropertyCache>& caches = chunk().caches;
+    if (caches.size() > MAX_INDEX) {
+        error("Too many property accesses in one chunk.");
+        return 0;
+    }
+
+    caches.emplace_back();
+    return static_cast<std::uint16_t>(caches.size() - 1);
+}
+
+std::uint16_t Compiler::makeMethodCache() {
+    std::vector<MethodCache>& caches = chunk().methodCaches;
+    if (caches.size() > MAX_INDEX) {
+        error("Too many method calls in one chunk.");
+        return 0;
+    }
+
+    caches.emplace_back();
+    return static_cast<std::uint16_t>(caches.size() - 1);
+}
+
+void Compiler::emitReturn() {
+    if (current->initializer) {
+        emit(OpCode::GET_LOCAL, 0);
+    }
+    else {
+        emit(OpCode::NIL);
+    }
+
+    emit(OpCode::RETURN);
+}
+
+// ---------- Scopes ----------
+void Compiler::beginScope() {
+    current->scopeDepth++;
+}
+
+void Compiler::endScope() {
+    current->scopeDepth--;
+
+    std::vector<Local>& locals = current->locals;
+    while (!locals.empty() && locals.back().depth > current->scopeDepth) {
+        emit(locals.back().captured ? OpCode::CLOSE_UPVALUE : OpCode::POP);
+        locals.pop_back();
+    }
+}
+
+void Compiler::declareLocal(const Token& name) {
+    if (current->locals.size() > MAX_INDEX) {
+        error("Too many local variables in function.");
+        return;
+    }
+
+    // Statements leave nothing else on the stack, so the value about
+    // to be pushed lands in this slot
+    current->locals.push_back({name.symbol, current->scopeDepth});
+}
+
+void Compiler::defineVariable(const Token& name) {
+    if (current->scopeDepth > 0) {
+        declareLocal(name);
+        return;
+    }
+
+    emit(OpCode::DEFINE_GLOBAL, makeName(name.symbol));
+}
+
+int Compiler::resolveLocal(FunctionState& state, int symbol) {
+    for (int i = static_cast<int>(state.locals.size()) - 1; i >= 0; i--) {
+        if (state.locals[i].symbol == symbol) return i;
+    }
+
+    return -1;
+}
+
+int Compiler::resolveUpvalue(FunctionState& state, int symbol) {
+    if (state.enclosing == nullptr) return -1;
+
+    int local = resolveLocal(*state.enclosing, symbol);
+    if (local != -1) {
+        state.enclosing->locals[local].captured = true;
+        return addUpvalue(state, local, true);
+    }
+
+    int upvalue = resolveUpvalue(*state.enclosing, symbol);
+    if (upvalue != -1) {
+        return addUpvalue(state, upvalue, false);
+    }
+
+    return -1;
+}
+
+int Compiler::addUpvalue(FunctionState& state, int index, bool isLocal) {
+    for (std::size_t i = 0; i < state.upvalues.size(); i++) {
+        const UpvalueRef& upvalue = state.upvalues[i];
+        if (upvalue.index == index && upvalue.isLocal == isLocal)
+            return static_cast<int>(i);
+    }
+
+    if (state.upvalues.size() > MAX_INDEX) {
+        error("Too many closure variables in function.");
+        return 0;
+    }
+
+    state.upvalues.push_back({static_cast<std::uint16_t>(index), isLocal});
+    return static_cast<int>(state.upvalues.size() - 1);
+}
+
+void Compiler::emitGet(const Token& name) {
+    line = name.line;
+
+    int slot = resolveLocal(*current, name.symbol);
+    if (slot != -1) {
+        emit(OpCode::GET_LOCAL, static_cast<std::uint16_t>(slot));
+        return;
+    }
+
+    int upvalue = resolveUpvalue(*current, name.symbol);
+    if (upvalue != -1) {
+        emit(OpCode::GET_UPVALUE, static_cast<std::uint16_t>(upvalue));
+        return;
+    }
+
+    emit(OpCode::GET_GLOBAL, makeName(name.symbol));
+}
+
+void Compiler::emitSet(const Token& name) {
+    line = name.line;
+
+    int slot = resolveLocal(*current, name.symbol);
+    if (slot != -1) {
+        emit(OpCode::SET_LOCAL, static_cast<std::uint16_t>(slot));
+        return;
+    }
+
+    int upvalue = resolveUpvalue(*current, name.symbol);
+    if (upvalue != -1) {
+        emit(OpCode::SET_UPVALUE, static_cast<std::uint16_t>(upvalue));
+        return;
+    }
+
+    emit(OpCode::SET_GLOBAL, makeName(name.symbol));
+}
+
+void Compiler::emitThis(const Token& near) {
+    static const int self = SymbolTable::intern("this");
+
+    Token keyword(TokenType::THIS, "this", near.line);
+    keyword.symbol = self;
+    emitGet(keyword);
+}
+
+void Compiler::error(const std::string& message) {
+    Runtime::error(line, message);
+    hadError = true;
+}
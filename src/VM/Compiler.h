@@ -0,0 +1,127 @@
+#pragma once
+
+#include "Chunk.h"
+#include "../Runtime/FlatAst.h"
+#include "../Token/Token.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Lowers a resolved program to bytecode for the VM, reading it from
+// its FlatAst encoding rather than the pointer tree.
+//
+// Variables are resolved the way the Resolver does it: names declared
+// in an enclosing block or function of the current body become stack
+// slots, names from enclosing functions become upvalues, and anything
+// else is a late-bound global.
+class Compiler {
+public:
+    // Returns the top-level script, or nullptr after reporting an error
+    static Ref<Prototype> compile(const FlatAst& ast);
+
+private:
+    struct Local {
+        int symbol;
+        int depth;
+        // Closed over by a nested function, so it must outlive its slot
+        bool captured = false;
+    };
+
+    struct UpvalueRef {
+        std::uint16_t index;
+        bool isLocal;
+    };
+
+    // One per function body being compiled, innermost last
+    struct FunctionState {
+        FunctionState* enclosing;
+        Ref<Prototype> function;
+        std::vector<Local> locals;
+        std::vector<UpvalueRef> upvalues;
+        int scopeDepth = 0;
+        // Returns `this` (slot 0) rather than nil
+        bool initializer = false;
+
+        // Modelled operand stack height, to size the frame
+        int stackDepth = 0;
+
+        // Constant index of each pooled literal already in this chunk
+        std::unordered_map<const Value*, std::uint16_t> constantIndex;
+        std::unordered_map<int, std::uint16_t> nameIndex;
+
+        FunctionState(FunctionState* enclosing, Ref<Prototype> function)
+            : enclosing(enclosing), function(std::move(function)) {}
+    };
+
+    using Index = FlatAst::Index;
+    using Kind = FlatAst::Kind;
+
+    const FlatAst& ast;
+    FunctionState* current = nullptr;
+    int line = 0;
+    bool hadError = false;
+
+    explicit Compiler(const FlatAst& ast) : ast(ast) {}
+
+    void compile(Index node);
+    // `statements` is a list operand
+    void compileBlock(Index statements);
+
+    // ---------- Expressions ----------
+    void binary(Index node);
+    void literal(Index node);
+    void unary(Index node);
+    void logical(Index node);
+    void call(Index node);
+    void get(Index node);
+    void set(Index node);
+    void super(Index node);
+
+    // ---------- Statements ----------
+    void varStatement(Index node);
+    void ifStatement(Index node);
+    void whileStatement(Index node);
+    void functionStatement(Index node);
+    void returnStatement(Index node);
+    void classStatement(Index node);
+    // Methods keep their receiver, `this`, in slot 0
+    void compileFunction(Index node, bool method = false);
+
+    // ---------- Emission ----------
+    Chunk& chunk() { return current->function->chunk; }
+    void emit(OpCode op);
+    void emit(OpCode op, std::uint16_t operand);
+    void emitByte(std::uint8_t byte);
+    void emitShort(std::uint16_t value);
+    void adjustStack(int delta);
+    std::size_t emitJump(OpCode op);
+    void patchJump(std::size_t operand);
+    void emitLoop(std::size_t loopStart);
+    std::uint16_t makeConstant(const Value& value);
+    std::uint16_t makeName(int symbol);
+    // A fresh inline cache for one property access
+    std::uint16_t makeCache();
+    std::uint16_t makeMethodCache();
+    // Return from the current function without a value
+    void emitReturn();
+
+    // ---------- Scopes ----------
+    void beginScope();
+    void endScope();
+    void declareLocal(const Token& name);
+    void defineVariable(const Token& name);
+    int resolveLocal(FunctionState& state, int symbol);
+    int resolveUpvalue(FunctionState& state, int symbol);
+    int addUpvalue(FunctionState& state, int index, bool isLocal);
+    void emitGet(const Token& name);
+    void emitSet(const Token& name);
+    // Push the receiver of the method around `near`
+    void emitThis(const Token& near);
+
+    // Limits of the encoding; reported against the current line
+    void error(const std::string& message);
+};
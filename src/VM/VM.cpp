@@ -0,0 +1,666 @@
+#include "VM.h"
+
+#include "../Runtime/Runtime.h"
+#include "../Runtime/SymbolTable.h"
+#include "../Runtime/ValueOps.h"
+#include "../Include/ClockCallable.h"
+#include "../Include/LoxBoundMethod.h"
+#include "../Include/LoxClass.h"
+#include "../Include/LoxInstance.h"
+
+#include <iostream>
+#include <variant>
+
+// Threaded dispatch (GCC/Clang "labels as values") unless told otherwise
+#ifndef CPPLOX_COMPUTED_GOTO
+#if defined(__GNUC__)
+#define CPPLOX_COMPUTED_GOTO 1
+#else
+#define CPPLOX_COMPUTED_GOTO 0
+#endif
+#endif
+
+VM::VM() : stack(std::make_unique<Value[]>(STACK_MAX)) {
+    stackTop = stack.get();
+    defineNative("clock", Value(Heap::make<ClockCallable>()));
+}
+
+void VM::defineNative(std::string_view name, Value function) {
+    int symbol = SymbolTable::intern(name);
+    if (static_cast<std::size_t>(symbol) >= globals.size())
+        globals.resize(symbol + 1);
+
+    globals[symbol] = {std::move(function), true};
+}
+
+Value Closure::call(Interpreter*, std::span<const Value> arguments) {
+    return vm.call(*this, arguments);
+}
+
+Value Closure::callMethod(
+    Interpreter*,
+    LoxInstance* receiver,
+    std::span<const Value> arguments)
+{
+    return vm.call(*this, arguments, receiver);
+}
+
+// ---------- Public API ----------
+void VM::interpret(Ref<Prototype> script) {
+    // Every name the script can mention was interned while lexing it
+    if (globals.size() < SymbolTable::size())
+        globals.resize(SymbolTable::size());
+
+    auto closure = Heap::make<Closure>(*this, std::move(script));
+
+    try {
+        Value* slots = stackTop;
+        *stackTop++ = closure;
+        pushFrame(*closure, slots);
+        run(0);
+
+        // Discard the script's nil result
+        stackTop--;
+    }
+    catch (const RuntimeError& error) {
+        Runtime::runtimeError(error);
+        resetStack();
+    }
+}
+
+Value VM::call(Closure& closure, std::span<const Value> arguments, LoxInstance* receiver) {
+    Value* slots = stackTop;
+
+    // The caller holds the closure, so the callee slot may stay nil
+    // unless it is the receiver
+    *stackTop++ = receiver != nullptr ? Value(receiver) : Value();
+    for (const Value& argument : arguments) {
+        *stackTop++ = argument;
+    }
+
+    pushFrame(closure, slots);
+    run(frameCount - 1);
+
+    return std::move(*--stackTop);
+}
+
+// ---------- Dispatch loop ----------
+void VM::run(int baseFrames) {
+    CallFrame* frame = &frames[frameCount - 1];
+    const Chunk* chunk = &frame->closure->function->chunk;
+    const std::uint8_t* ip = frame->ip;
+    Value* sp = stackTop;
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, static_cast<std::uint16_t>(ip[-2] | (ip[-1] << 8)))
+#define READ_NAME() (chunk->names[READ_SHORT()])
+#define READ_CACHE() (chunk->caches[READ_SHORT()])
+// Save the registers the error path, callees and the collector look at
+#define SYNC() (frame->ip = ip, stackTop = sp)
+#define THROW(message) do { SYNC(); throw error(message); } while (false)
+// Switch the registers to the frame a call just pushed
+#define FRAME_PUSHED() {                                   \
+        frame = &frames[frameCount - 1];                   \
+        chunk = &frame->closure->function->chunk;          \
+        ip = frame->ip;                                    \
+        sp = stackTop;                                     \
+        DISPATCH();                                        \
+    }
+
+#define NUMBER_OPERANDS(a, b)                              \
+    if (!sp[-2].isNumber() || !sp[-1].isNumber())          \
+        THROW("Operand must be a numbers.");               \
+    double a = sp[-2].asNumber();                          \
+    double b = sp[-1].asNumber()
+
+#define BINARY_OP(op) {                                    \
+        NUMBER_OPERANDS(a, b);                             \
+        auto result = a op b;                              \
+        sp[-2] = result;                                   \
+        sp--;                                              \
+        DISPATCH();                                        \
+    }
+
+#if CPPLOX_COMPUTED_GOTO
+    static void* const dispatchTable[] = {
+#define CPPLOX_OPCODE_LABEL(name) &&op_##name,
+        CPPLOX_OPCODES(CPPLOX_OPCODE_LABEL)
+#undef CPPLOX_OPCODE_LABEL
+    };
+
+#define DISPATCH() goto *dispatchTable[READ_BYTE()]
+#define CASE(name) op_##name:
+
+    DISPATCH();
+#else
+#define DISPATCH() continue
+#define CASE(name) case OpCode::name:
+
+    for (;;) {
+    switch (static_cast<OpCode>(READ_BYTE())) {
+#endif
+
+    CASE(CONSTANT) {
+        *sp++ = chunk->constants[READ_SHORT()];
+        DISPATCH();
+    }
+
+    CASE(NIL) {
+        *sp++ = std::monostate{};
+        DISPATCH();
+    }
+
+    CASE(TRUE) {
+        *sp++ = true;
+        DISPATCH();
+    }
+
+    CASE(FALSE) {
+        *sp++ = false;
+        DISPATCH();
+    }
+
+    CASE(POP) {
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(GET_LOCAL) {
+        *sp++ = frame->slots[READ_SHORT()];
+        DISPATCH();
+    }
+
+    CASE(SET_LOCAL) {
+        frame->slots[READ_SHORT()] = sp[-1];
+        DISPATCH();
+    }
+
+    CASE(GET_UPVALUE) {
+        *sp++ = *frame->closure->upvalues[READ_SHORT()]->location;
+        DISPATCH();
+    }
+
+    CASE(SET_UPVALUE) {
+        *frame->closure->upvalues[READ_SHORT()]->location = sp[-1];
+        DISPATCH();
+    }
+
+    CASE(GET_GLOBAL) {
+        int symbol = READ_NAME();
+        const Global& global = globals[symbol];
+        if (!global.defined)
+            THROW("Undefined variable '" + std::string(SymbolTable::name(symbol)) + "'.");
+
+        *sp++ = global.value;
+        DISPATCH();
+    }
+
+    CASE(DEFINE_GLOBAL) {
+        Global& global = globals[READ_NAME()];
+        global.value = std::move(sp[-1]);
+        global.defined = true;
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(SET_GLOBAL) {
+        int symbol = READ_NAME();
+        Global& global = globals[symbol];
+        if (!global.defined)
+            THROW("Undefined variable '" + std::string(SymbolTable::name(symbol)) + "'.");
+
+        global.value = sp[-1];
+        DISPATCH();
+    }
+
+    CASE(GET_PROPERTY) {
+        int symbol = READ_NAME();
+        PropertyCache& cache = READ_CACHE();
+        if (!sp[-1].isInstance())
+            THROW("Only instances have properties.");
+
+        LoxInstance* instance = sp[-1].asInstance();
+        if (const Value* field = instance->cached(cache)) {
+            sp[-1] = *field;
+            DISPATCH();
+        }
+
+        SYNC();
+        Token name(IDENTIFIER, SymbolTable::name(symbol), currentLine());
+        name.symbol = symbol;
+
+        Value value = instance->get(name, cache);
+        sp[-1] = std::move(value);
+        DISPATCH();
+    }
+
+    CASE(CHECK_FIELDS) {
+        ip += 2;
+        if (!sp[-1].isInstance())
+            THROW("Only instances have fields.");
+        DISPATCH();
+    }
+
+    CASE(SET_PROPERTY) {
+        int symbol = READ_NAME();
+        PropertyCache& cache = READ_CACHE();
+        // CHECK_FIELDS already vetted the receiver
+        LoxInstance* instance = sp[-2].asInstance();
+
+        Token name(IDENTIFIER, SymbolTable::name(symbol), 0);
+        name.symbol = symbol;
+        instance->set(name, sp[-1], cache);
+
+        sp[-2] = std::move(sp[-1]);
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(EQUAL) {
+        bool equal = ValueOps::isEqual(sp[-2], sp[-1]);
+        sp[-2] = equal;
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(NOT_EQUAL) {
+        bool equal = ValueOps::isEqual(sp[-2], sp[-1]);
+        sp[-2] = !equal;
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(GREATER)       BINARY_OP(>)
+    CASE(GREATER_EQUAL) BINARY_OP(>=)
+    CASE(LESS)          BINARY_OP(<)
+    CASE(LESS_EQUAL)    BINARY_OP(<=)
+    CASE(SUBTRACT)      BINARY_OP(-)
+    CASE(MULTIPLY)      BINARY_OP(*)
+    CASE(DIVIDE)        BINARY_OP(/)
+
+    CASE(ADD) {
+        if (sp[-2].isNumber()) {
+            if (sp[-1].isNumber()) {
+                sp[-2] = sp[-2].asNumber() + sp[-1].asNumber();
+                sp--;
+                DISPATCH();
+            }
+        }
+        else if (sp[-2].isString()) {
+            if (sp[-1].isString()) {
+                sp[-2] = LoxString::concat(sp[-2].asString(), sp[-1].asString());
+                sp--;
+                DISPATCH();
+            }
+        }
+
+        THROW("Operands must be two numbers or two strings.");
+    }
+
+    CASE(NOT) {
+        sp[-1] = !ValueOps::isTruthy(sp[-1]);
+        DISPATCH();
+    }
+
+    CASE(NEGATE) {
+        if (!sp[-1].isNumber())
+            THROW("Operand must be a number.");
+
+        sp[-1] = -sp[-1].asNumber();
+        DISPATCH();
+    }
+
+    CASE(PRINT) {
+        std::cout << ValueOps::stringify(sp[-1]) << '\n';
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(JUMP) {
+        std::uint16_t offset = READ_SHORT();
+        ip += offset;
+        DISPATCH();
+    }
+
+    CASE(JUMP_IF_FALSE) {
+        std::uint16_t offset = READ_SHORT();
+        if (!ValueOps::isTruthy(sp[-1])) ip += offset;
+        DISPATCH();
+    }
+
+    CASE(JUMP_IF_TRUE) {
+        std::uint16_t offset = READ_SHORT();
+        if (ValueOps::isTruthy(sp[-1])) ip += offset;
+        DISPATCH();
+    }
+
+    CASE(LOOP) {
+        std::uint16_t offset = READ_SHORT();
+        ip -= offset;
+        DISPATCH();
+    }
+
+    CASE(CALL) {
+        int argCount = READ_BYTE();
+        Value* callee = sp - argCount - 1;
+
+        SYNC();
+        if (callValue(callee, argCount)) {
+            FRAME_PUSHED()
+        }
+
+        sp = callee + 1;
+        DISPATCH();
+    }
+
+    CASE(INVOKE) {
+        int symbol = READ_NAME();
+        PropertyCache& fieldCache = READ_CACHE();
+        MethodCache& methodCache = chunk->methodCaches[READ_SHORT()];
+        int argCount = READ_BYTE();
+        Value* receiver = sp - argCount - 1;
+
+        if (!receiver->isInstance())
+            THROW("Only instances have properties.");
+
+        LoxInstance* instance = receiver->asInstance();
+        LoxCallable* method = instance->cachedMethod(methodCache);
+        SYNC();
+
+        if (method == nullptr) {
+            Token name(IDENTIFIER, SymbolTable::name(symbol), currentLine());
+            name.symbol = symbol;
+            method = instance->method(name, methodCache);
+
+            // A field holding something callable, or no such property
+            if (method == nullptr) {
+                *receiver = instance->get(name, fieldCache);
+
+                if (callValue(receiver, argCount)) {
+                    FRAME_PUSHED()
+                }
+
+                sp = receiver + 1;
+                DISPATCH();
+            }
+        }
+
+        if (callMethod(*method, receiver, argCount)) {
+            FRAME_PUSHED()
+        }
+
+        sp = receiver + 1;
+        DISPATCH();
+    }
+
+    CASE(CLOSURE) {
+        const Ref<Prototype>& function = chunk->functions[READ_SHORT()];
+
+        SYNC();
+        auto closure = Heap::make<Closure>(*this, function);
+
+        // On the stack before capturing, which may collect
+        *sp++ = closure;
+        stackTop = sp;
+
+        for (int i = 0; i < function->upvalueCount; i++) {
+            bool isLocal = READ_BYTE() != 0;
+            std::uint16_t index = READ_SHORT();
+
+            closure->upvalues[i] = isLocal ? captureUpvalue(frame->slots + index)
+                                           : frame->closure->upvalues[index];
+        }
+
+        DISPATCH();
+    }
+
+    CASE(CLOSE_UPVALUE) {
+        closeUpvalues(sp - 1);
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(RETURN) {
+        Value result = std::move(sp[-1]);
+        closeUpvalues(frame->slots);
+
+        // The result replaces the callee
+        sp = frame->slots;
+        *sp++ = std::move(result);
+        frameCount--;
+
+        if (frameCount == baseFrames) {
+            stackTop = sp;
+            return;
+        }
+
+        frame = &frames[frameCount - 1];
+        chunk = &frame->closure->function->chunk;
+        ip = frame->ip;
+        DISPATCH();
+    }
+
+    CASE(GET_SUPER) {
+        int symbol = READ_NAME();
+        MethodCache& cache = chunk->methodCaches[READ_SHORT()];
+
+        // Only a class is ever stored in `super`
+        auto superclass = static_cast<LoxClass*>(sp[-1].asCallable());
+        LoxCallable* method = superclass->findMethod(symbol, cache);
+        if (method == nullptr)
+            THROW("Undefined property '" + std::string(SymbolTable::name(symbol)) + "'.");
+
+        SYNC();
+        auto bound = Heap::make<LoxBoundMethod>(sp[-2].asInstance(), method);
+        sp[-2] = bound;
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(SUPER_INVOKE) {
+        int symbol = READ_NAME();
+        MethodCache& cache = chunk->methodCaches[READ_SHORT()];
+        int argCount = READ_BYTE();
+
+        auto superclass = static_cast<LoxClass*>(sp[-1].asCallable());
+        LoxCallable* method = superclass->findMethod(symbol, cache);
+        if (method == nullptr)
+            THROW("Undefined property '" + std::string(SymbolTable::name(symbol)) + "'.");
+
+        sp--;
+        Value* receiver = sp - argCount - 1;
+
+        SYNC();
+        if (callMethod(*method, receiver, argCount)) {
+            FRAME_PUSHED()
+        }
+
+        sp = receiver + 1;
+        DISPATCH();
+    }
+
+    CASE(CLASS) {
+        int symbol = READ_NAME();
+
+        SYNC();
+        *sp++ = Heap::make<LoxClass>(std::string(SymbolTable::name(symbol)));
+        DISPATCH();
+    }
+
+    CASE(INHERIT) {
+        LoxClass* superclass = sp[-2].isCallable() ? dynamic_cast<LoxClass*>(sp[-2].asCallable())
+                                                   : nullptr;
+        if (superclass == nullptr)
+            THROW("Superclass must be a class.");
+
+        static_cast<LoxClass*>(sp[-1].asCallable())->inherit(*superclass);
+        sp--;
+        DISPATCH();
+    }
+
+    CASE(METHOD) {
+        // Only the compiler's class bodies put a class under a closure here
+        auto klass = static_cast<LoxClass*>(sp[-2].asCallable());
+        klass->addMethod(READ_NAME(), sp[-1].asCallable());
+        sp--;
+        DISPATCH();
+    }
+
+#if !CPPLOX_COMPUTED_GOTO
+    }
+    }
+#endif
+
+#undef READ_BYTE
+#undef READ_SHORT
+#undef READ_NAME
+#undef READ_CACHE
+#undef SYNC
+#undef THROW
+#undef FRAME_PUSHED
+#undef NUMBER_OPERANDS
+#undef BINARY_OP
+#undef DISPATCH
+#undef CASE
+}
+
+// ---------- Frames and upvalues ----------
+void VM::pushFrame(Closure& closure, Value* slots) {
+    const Prototype& function = *closure.function;
+
+    if (frameCount == FRAMES_MAX || slots + function.maxSlots > stack.get() + STACK_MAX)
+        throw error(CallDepth::MESSAGE);
+
+    frames[frameCount++] = {&closure, function.chunk.code.data(), slots};
+}
+
+bool VM::callValue(Value* callee, int argCount) {
+    if (!callee->isCallable())
+        throw error("Can only call function and classes.");
+
+    LoxCallable* callable = callee->asCallable();
+
+    if (auto closure = dynamic_cast<Closure*>(callable)) {
+        checkArity(*closure, argCount);
+        pushFrame(*closure, callee);
+        return true;
+    }
+
+    // The method runs with its receiver in place of the bound method
+    if (auto bound = dynamic_cast<LoxBoundMethod*>(callable)) {
+        *callee = bound->receiver;
+        return callMethod(*bound->method, callee, argCount);
+    }
+
+    checkArity(*callable, argCount);
+    checkDepth();
+
+    // The new instance takes the class's slot and becomes `this`; it
+    // keeps the class alive from there
+    if (auto klass = dynamic_cast<LoxClass*>(callable)) {
+        *callee = Heap::make<LoxInstance>(klass);
+
+        if (klass->initializer == nullptr) return false;
+        return callMethod(*klass->initializer, callee, argCount);
+    }
+
+    // Natives see the arguments in place and may call back into run().
+    // The callee and arguments stay on the stack, which keeps them alive
+    *callee = callable->call(nullptr, std::span<const Value>(callee + 1, argCount));
+    return false;
+}
+
+bool VM::callMethod(LoxCallable& method, Value* slots, int argCount) {
+    checkArity(method, argCount);
+
+    if (auto closure = dynamic_cast<Closure*>(&method)) {
+        pushFrame(*closure, slots);
+        return true;
+    }
+
+    checkDepth();
+    std::span<const Value> arguments(slots + 1, argCount);
+    *slots = method.callMethod(nullptr, slots->asInstance(), arguments);
+    return false;
+}
+
+void VM::checkDepth() const {
+    // Calls that push no frame still count, as they do in the other engines
+    if (frameCount == FRAMES_MAX)
+        throw error(CallDepth::MESSAGE);
+}
+
+void VM::checkArity(const LoxCallable& callable, int argCount) const {
+    if (argCount != callable.arity()) {
+        throw error("Expected " + std::to_string(callable.arity()) +
+                    " arguments but got " + std::to_string(argCount) + ".");
+    }
+}
+
+Upvalue* VM::captureUpvalue(Value* slot) {
+    Upvalue** link = &openUpvalues;
+
+    while (*link != nullptr && (*link)->location > slot) {
+        link = &(*link)->next;
+    }
+
+    if (*link != nullptr && (*link)->location == slot) return *link;
+
+    auto created = Heap::make<Upvalue>(slot);
+
+    // Allocating may have collected, but never unlinks open upvalues;
+    // the list is unchanged
+    created->next = *link;
+    *link = created;
+    return created;
+}
+
+void VM::closeUpvalues(const Value* last) {
+    while (openUpvalues != nullptr && openUpvalues->location >= last) {
+        Upvalue* upvalue = openUpvalues;
+
+        upvalue->closed = std::move(*upvalue->location);
+        upvalue->location = &upvalue->closed;
+        openUpvalues = upvalue->next;
+        upvalue->next = nullptr;
+    }
+}
+
+// ---------- Garbage collection ----------
+void VM::markRoots() {
+    for (const Value* slot = stack.get(); slot < stackTop; slot++)
+        Heap::mark(*slot);
+
+    for (int i = 0; i < frameCount; i++)
+        Heap::mark(frames[i].closure);
+
+    for (const Upvalue* upvalue = openUpvalues; upvalue != nullptr; upvalue = upvalue->next)
+        Heap::mark(upvalue);
+
+    for (const Global& global : globals)
+        Heap::mark(global.value);
+}
+
+// ---------- Errors ----------
+RuntimeError VM::error(const std::string& message) const {
+    return RuntimeError(Token(IDENTIFIER, "", currentLine()), message);
+}
+
+int VM::currentLine() const {
+    if (frameCount == 0) return 0;
+
+    const CallFrame& frame = frames[frameCount - 1];
+    const Chunk& chunk = frame.closure->function->chunk;
+
+    // ip has moved past the opcode, onto the operands or the next instruction
+    std::size_t offset = frame.ip - chunk.code.data();
+    return offset == 0 ? 0 : chunk.lines[offset - 1];
+}
+
+void VM::resetStack() {
+    // Captured variables keep the values they had
+    closeUpvalues(stack.get());
+
+    stackTop = stack.get();
+    frameCount = 0;
+}
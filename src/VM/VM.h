@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Chunk.h"
+#include "Closure.h"
+#include "../Runtime/CallDepth.h"
+#include "../Runtime/Heap.h"
+#include "../Runtime/Value.h"
+#include "../Interpreter/RuntimeError.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Stack-based bytecode interpreter for programs built by Compiler.
+//
+// Each call gets a window of the shared value stack: slot 0 holds the
+// callee, then the arguments, then locals and temporaries. Globals
+// live in a table indexed by SymbolTable id and persist across
+// interpret() calls, so REPL lines see each other's definitions.
+class VM {
+public:
+    VM();
+    VM(const VM&) = delete;
+    VM& operator=(const VM&) = delete;
+
+    // Run a compiled script; runtime errors are reported through Runtime
+    void interpret(Ref<Prototype> script);
+
+    // Run a closure to completion on behalf of native code, with
+    // `receiver` as `this` when it is a method
+    Value call(Closure& closure, std::span<const Value> arguments,
+               LoxInstance* receiver = nullptr);
+
+private:
+    // One frame per call in progress, plus the script's own
+    static constexpr int FRAMES_MAX = CallDepth::MAX + 1;
+    static constexpr int STACK_MAX = 64 * 1024;
+
+    struct CallFrame {
+        Closure* closure;
+        // Resume point; only up to date while the frame is not running
+        const std::uint8_t* ip;
+        Value* slots;
+    };
+
+    struct Global {
+        Value value;
+        bool defined = false;
+    };
+
+    std::unique_ptr<Value[]> stack;
+    Value* stackTop;
+    std::array<CallFrame, FRAMES_MAX> frames;
+    int frameCount = 0;
+
+    // Captures still pointing into the stack, highest slot first
+    Upvalue* openUpvalues = nullptr;
+
+    std::vector<Global> globals;
+
+    // Execute until the frame count drops back to `baseFrames`
+    void run(int baseFrames);
+
+    // Push a frame for `closure` whose callee slot is `slots`
+    void pushFrame(Closure& closure, Value* slots);
+
+    // Call the value in `callee` on the `argCount` values above it, or
+    // `method` on the instance in `slots`. Returns true after pushing a
+    // frame for a closure; anything else has run and left its result in
+    // the callee's slot
+    bool callValue(Value* callee, int argCount);
+    bool callMethod(LoxCallable& method, Value* slots, int argCount);
+    void checkDepth() const;
+    void checkArity(const LoxCallable& callable, int argCount) const;
+
+    Upvalue* captureUpvalue(Value* slot);
+    void closeUpvalues(const Value* last);
+
+    void defineNative(std::string_view name, Value function);
+
+    // Error at the instruction the innermost frame stopped on
+    RuntimeError error(const std::string& message) const;
+    int currentLine() const;
+    void resetStack();
+    void markRoots();
+
+    Heap::Roots roots{[this] { markRoots(); }};
+};
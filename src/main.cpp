@@ -1,17 +1,42 @@
 #include "Runtime/Runtime.h"
 #include <iostream>
+#include <string>
 
 int main(int argc, char *argv[]){
-    // Handle 2 Arguments:
+    // Handle Arguments:
     // 1. cpplox (interpreter)
-    // 2. script (path of script to run)
-    if (argc > 2) {
-        std::cerr << "Usage: cpplox [script]\n";
-        return 64; // exit with error
-    } 
+    // 2. options (--engine=tree|vm|closure, --dump-tokens, --dump-ast,
+    //    --dump-flat-ast, --dump-bytecode, --gc-stress, --gc-stats)
+    // 3. script (path of script to run, "-" for stdin)
+    Runtime::Options options;
+    std::string script;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--engine=tree") options.engine = Runtime::Engine::TREE;
+        else if (arg == "--engine=vm") options.engine = Runtime::Engine::VM;
+        else if (arg == "--engine=closure") options.engine = Runtime::Engine::CLOSURE;
+        else if (arg == "--dump-tokens") options.dumpTokens = true;
+        else if (arg == "--dump-ast") options.dumpAst = true;
+        else if (arg == "--dump-flat-ast") options.dumpFlatAst = true;
+        else if (arg == "--dump-bytecode") options.dumpBytecode = true;
+        else if (arg == "--gc-stress") options.gcStress = true;
+        else if (arg == "--gc-stats") options.gcStats = true;
+        else if (script.empty() && (arg == "-" || arg[0] != '-')) script = arg;
+        else {
+            std::cerr << "Usage: cpplox [--engine=tree|vm|closure] [--dump-tokens] [--dump-ast]"
+                         " [--dump-flat-ast] [--dump-bytecode] [--gc-stress] [--gc-stats]"
+                         " [script]\n";
+            return 64; // exit with error
+        }
+    }
+
+    Runtime::configure(options);
+
     // Process file if path exist
-    else if (argc == 2) { 
-        return Runtime::processFile(argv[1]);
+    if (!script.empty()) { 
+        return Runtime::processFile(script);
     }
     // Launch Read-Eval-Print Loop (REPL) 
     else {